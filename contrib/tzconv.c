@@ -92,23 +92,38 @@ mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 		mwSize n = mxGetN(prhs[0]);
 		const double *src = mxGetPr(prhs[0]);
 		double *tgt;
+		int64_t *ts;
 
 		plhs[0] = mxCreateDoubleMatrix(m, n, mxREAL);
 		tgt = mxGetPr(plhs[0]);
+		ts = mxMalloc(m * n * sizeof(*ts));
 
+		/* split into whole seconds and fractions, the latter
+		 * are parked in TGT, NaN marks the out-of-range ones */
 		for (mwSize i = 0; i < m * n; i++) {
 			double x = TO_UNIX(src[i]);
 
 			if (x < 2147483647.0 && x > -2147483648.0) {
-				double frac = modf(x, &x);
-				int32_t utc = zif_utc_time(fromz, (int32_t)x);
-				int32_t lcl = zif_local_time(toz, utc);
-
-				tgt[i] = TO_MATL((double)lcl) + frac / 86400.0;
+				tgt[i] = modf(x, &x);
+				ts[i] = (int64_t)x;
 			} else {
 				tgt[i] = NAN;
+				ts[i] = 0;
+			}
+		}
+		/* convert the whole lot in one go */
+		if (zif_convert_n(fromz, toz, ts, ts, m * n) < 0) {
+			mxFree(ts);
+			zif_close(fromz);
+			zif_close(toz);
+			mexErrMsgTxt("cannot merge zones\n");
+		}
+		for (mwSize i = 0; i < m * n; i++) {
+			if (!isnan(tgt[i])) {
+				tgt[i] = TO_MATL((double)ts[i]) + tgt[i] / 86400.0;
 			}
 		}
+		mxFree(ts);
 	}
 
 	zif_close(fromz);
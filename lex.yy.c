@@ -0,0 +1,74 @@
+/* hand-written stand-in for the flex-generated dexpr scanner */
+#include "dexpr.h"
+#include "dexpr-parser.h"
+extern int yyparse();
+char *yytext;
+static int yyleng;
+static char *yy_cur;
+static char yy_hold;
+static char *yy_holdp;
+
+static int yy_isin(int c, const char *set) { return c && strchr(set, c) != NULL; }
+
+int
+yylex(YYSTYPE *yylval)
+{
+	int best, bestr;
+	char *s;
+again:
+	if (yy_holdp) { *yy_holdp = yy_hold; yy_holdp = NULL; }
+	s = yy_cur;
+	if (!*s) return 0;
+	best = 0, bestr = 0;
+#define CAND(r, l) do { int _l = (l); if (_l > best) { best = _l; bestr = r; } } while (0)
+	if (s[0] == '=') CAND(1, s[1] == '=' ? 2 : 1);
+	if (s[0] == '!' && s[1] == '=') CAND(2, 2);
+	if (s[0] == '<') CAND(3, 1);
+	if (s[0] == '<' && s[1] == '=') CAND(4, 2);
+	if (s[0] == '>') CAND(5, 1);
+	if (s[0] == '>' && s[1] == '=') CAND(6, 2);
+	if (s[0] == '|' && s[1] == '|') CAND(7, 2);
+	if (s[0] == '&' && s[1] == '&') CAND(8, 2);
+	if (s[0] == '!') CAND(9, 1);
+	if (s[0] == '(') CAND(10, 1);
+	if (s[0] == ')') CAND(11, 1);
+	if (s[0] == '%') { int l = 1; while (s[l] == '_' || (s[l] >= 'a' && s[l] <= 'z') || (s[l] >= 'A' && s[l] <= 'Z')) l++; CAND(12, l); }
+	if (s[0] == '"' || s[0] == '\'') {
+		char q = s[0]; int l = 1;
+		while (s[l] && s[l] != q) { if (s[l] == '\\' && s[l + 1]) l += 2; else l++; }
+		if (s[l] == q) CAND(13, l + 1);
+	}
+	if (s[0] >= '0' && s[0] <= '9') { int l = 0; while (s[l] >= '0' && s[l] <= '9') l++; CAND(14, l); }
+	if (!yy_isin(s[0], "\v\n\f()!&|<>= ")) { int l = 1; while (s[l] && !yy_isin(s[l], "\v\n\f()!&|<>=")) l++; CAND(15, l); }
+	if (yy_isin(s[0], " \t\v\n\f")) CAND(16, 1);
+	if (s[0] != '\n') CAND(17, 1);
+	if (!best) CAND(17, 1);
+	yytext = s; yyleng = best; yy_cur = s + best;
+	yy_holdp = yy_cur; yy_hold = *yy_cur; *yy_cur = '\0';
+	switch (bestr) {
+	case 1: return TOK_EQ; case 2: return TOK_NE; case 3: return TOK_LT;
+	case 4: return TOK_LE; case 5: return TOK_GT; case 6: return TOK_GE;
+	case 7: return TOK_OR; case 8: return TOK_AND; case 9: return TOK_NOT;
+	case 10: return TOK_LPAREN; case 11: return TOK_RPAREN;
+	case 12: yylval->sval = yytext; return TOK_SPEC;
+	case 13: yytext[yyleng - 1] = '\0'; yylval->sval = yytext + 1; return TOK_STRING;
+	case 14: yylval->sval = yytext; return TOK_INT;
+	case 15: yylval->sval = yytext; return TOK_DATETIME;
+	default: goto again;
+	}
+}
+
+int
+dexpr_parse(dexpr_t *root, const char *s, size_t l)
+{
+	char *scan;
+	int res;
+	if ((scan = malloc(l + 2)) == NULL) return -1;
+	memcpy(scan, s, l);
+	scan[l++] = '\0';
+	scan[l++] = '\0';
+	yy_cur = scan; yy_holdp = NULL;
+	res = yyparse(root);
+	yy_holdp = NULL;
+	return (res == 0) - 1;
+}
@@ -0,0 +1,510 @@
+/*** bizcal.c -- business day calendars
+ *
+ * Copyright (C) 2019 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of dateutils.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+/* for fgetln() */
+#define _NETBSD_SOURCE
+#define _DARWIN_SOURCE
+#define _ALL_SOURCE
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#if defined HAVE_SYS_STDINT_H
+# include <sys/stdint.h>
+#endif	/* HAVE_SYS_STDINT_H */
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "bizcal.h"
+#include "boops.h"
+
+#if !defined LIKELY
+# define LIKELY(_x)     __builtin_expect((_x), 1)
+#endif  /* !LIKELY */
+#if !defined UNLIKELY
+# define UNLIKELY(_x)   __builtin_expect((_x), 0)
+#endif  /* UNLIKELY */
+
+#if !defined countof
+# define countof(x)     (sizeof(x) / sizeof(*x))
+#endif  /* !countof */
+
+#if !defined HAVE_GETLINE && !defined HAVE_FGETLN
+/* as a service to people including this file in their project
+ * but who might not necessarily run the corresponding AC_CHECK_FUNS
+ * we assume that a getline() is available. */
+# define HAVE_GETLINE   1
+#endif  /* !HAVE_GETLINE && !HAVE_FGETLN */
+
+#if !defined DEFUN
+# define DEFUN
+#endif	/* !DEFUN */
+
+
+#if defined STANDALONE
+static __attribute__((format(printf, 1, 2))) void
+error(const char *fmt, ...)
+{
+        va_list vap;
+        va_start(vap, fmt);
+        vfprintf(stderr, fmt, vap);
+        va_end(vap);
+        fputc('\n', stderr);
+        return;
+}
+
+static __attribute__((format(printf, 1, 2))) void
+serror(const char *fmt, ...)
+{
+        va_list vap;
+        va_start(vap, fmt);
+        vfprintf(stderr, fmt, vap);
+        va_end(vap);
+        if (errno) {
+                fputc(':', stderr);
+                fputc(' ', stderr);
+                fputs(strerror(errno), stderr);
+        }
+        fputc('\n', stderr);
+        return;
+}
+#endif	/* STANDALONE */
+
+static void*
+deconst(const void *ptr)
+{
+	return (char*)1 + ((const char*)ptr - (char*)1U);
+}
+
+
+/* public API */
+static inline size_t
+bzc_file_size(bizcal_t c)
+{
+	return c->flags[1U];
+}
+
+static inline int
+bzc_fd(bizcal_t c)
+{
+	return c->flags[0U];
+}
+
+DEFUN bizcal_t
+bzc_open(const char *fn)
+{
+#define FAIL	(bizcal_t)MAP_FAILED
+#define BZCP	(PROT_READ | PROT_WRITE)
+	struct stat st[1U];
+	size_t fz;
+	struct bizcal_s *c;
+	int fd;
+
+	if ((fd = open(fn, O_RDONLY)) < 0) {
+		return NULL;
+	} else if (fstat(fd, st) < 0) {
+		goto clo;
+	} else if ((fz = st->st_size) < sizeof(*c)) {
+		goto clo;
+	} else if ((c = mmap(0, fz, BZCP, MAP_PRIVATE, fd, 0)) == FAIL) {
+		goto clo;
+	} else if (memcmp(c->magic, BZC_MAGIC, sizeof(c->magic))) {
+		goto mun;
+	}
+	/* turn everything into native endianness */
+	c->y0 = be16toh(c->y0);
+	c->ny = be16toh(c->ny);
+	if (fz < sizeof(*c) + c->ny * sizeof(*c->yrs)) {
+		/* truncated */
+		goto mun;
+	}
+	for (size_t i = 0U; i < c->ny; i++) {
+		struct bizcal_yr_s *r = c->yrs + i;
+
+		for (size_t j = 0U; j < countof(r->msk); j++) {
+			r->msk[j] = be64toh(r->msk[j]);
+			r->pfx[j] = be16toh(r->pfx[j]);
+		}
+		r->cum = be32toh(r->cum);
+	}
+	/* also put fd and map size into c */
+	c->flags[0U] = (uint32_t)fd;
+	c->flags[1U] = (uint32_t)st->st_size;
+	/* and here we go */
+	return c;
+
+#undef FAIL
+#undef BZCP
+	/* failure cases, clean up and return NULL */
+mun:
+	munmap(c, st->st_size);
+clo:
+	close(fd);
+	return NULL;
+}
+
+DEFUN void
+bzc_close(bizcal_t c)
+{
+	size_t fz = bzc_file_size(c);
+	int fd = bzc_fd(c);
+
+	/* hopefully privately mapped */
+	munmap(deconst(c), fz);
+	close(fd);
+	return;
+}
+
+
+#if defined STANDALONE
+/* gregorian helpers, we don't want to drag in all of libdut */
+static inline bool
+leapp(unsigned int y)
+{
+	return !(y % 4U) && ((y % 100U) || !(y % 400U));
+}
+
+static unsigned int
+get_yday(unsigned int y, unsigned int m, unsigned int d)
+{
+	static const uint16_t cumd[] = {
+		0U, 31U, 59U, 90U, 120U, 151U,
+		181U, 212U, 243U, 273U, 304U, 334U, 365U,
+	};
+	const unsigned int mdays =
+		cumd[m] - cumd[m - 1U] + (m == 2U && leapp(y));
+
+	if (UNLIKELY(d == 0U || d > mdays)) {
+		return 0U;
+	}
+	return cumd[m - 1U] + d + (m > 2U && leapp(y));
+}
+
+static unsigned int
+get_md(unsigned int y, unsigned int yd)
+{
+/* return month * 32 + day of month of day-of-year YD in Y */
+	unsigned int m;
+
+	for (m = 1U; m < 12U && yd >= get_yday(y, m + 1U, 1U); m++);
+	return m * 32U + yd - get_yday(y, m, 1U) + 1U;
+}
+
+static unsigned int
+get_jan01_wday(unsigned int y)
+{
+/* 0 is Sunday, 6 is Saturday */
+	const unsigned int p = y - 1U;
+	return (1U + 5U * (p % 4U) + 4U * (p % 100U) + 6U * (p % 400U)) % 7U;
+}
+
+/* holidays we've seen, as YYYY * 512 + YD */
+static uint32_t *hols;
+static size_t holz;
+static size_t holi;
+
+static int
+parse_line(const char *ln, size_t lz)
+{
+	unsigned int y, m, d, yd;
+	int n;
+
+	if (lz == 0U || *ln == '#') {
+		/* comment or empty line */
+		return 0;
+	} else if (sscanf(ln, "%4u-%2u-%2u%n", &y, &m, &d, &n) < 3) {
+		return -1;
+	} else if ((size_t)n < lz && ln[n] != ' ' && ln[n] != '\t') {
+		return -1;
+	} else if (y < 1U || y > 9999U || m < 1U || m > 12U) {
+		return -1;
+	} else if (!(yd = get_yday(y, m, d))) {
+		return -1;
+	}
+	/* append */
+	if (holi >= holz) {
+		hols = realloc(hols, (holz = (holz * 2U) ?: 256U) * sizeof(*hols));
+	}
+	hols[holi++] = y * 512U + yd;
+	return 0;
+}
+
+static int
+parse_file(const char *file)
+{
+	char *line = NULL;
+	size_t llen = 0U;
+	unsigned int lno = 0U;
+	FILE *fp;
+	int rc = 0;
+
+	if (file == NULL) {
+		fp = stdin;
+		file = "-";
+	} else if ((fp = fopen(file, "r")) == NULL) {
+		return -1;
+	}
+
+#if defined HAVE_GETLINE
+	for (ssize_t nrd; (nrd = getline(&line, &llen, fp)) > 0; lno++) {
+		if (parse_line(line, nrd - 1) < 0) {
+			error("Error in %s:%u: cannot parse date", file, lno + 1U);
+			rc = -1;
+		}
+	}
+#elif defined HAVE_FGETLN
+	for (; (line = fgetln(fp, &llen)) != NULL && llen > 0U; lno++) {
+		if (parse_line(line, llen - 1) < 0) {
+			error("Error in %s:%u: cannot parse date", file, lno + 1U);
+			rc = -1;
+		}
+	}
+#else
+# error neither getline() nor fgetln() available, cannot read file line by line
+#endif	/* GETLINE/FGETLN */
+
+#if defined HAVE_GETLINE
+	/* free line buffer resources */
+	free(line);
+#endif	/* HAVE_GETLINE */
+
+	fclose(fp);
+	return rc;
+}
+
+static int
+hol_cmp(const void *a, const void *b)
+{
+	const uint32_t x = *(const uint32_t*)a;
+	const uint32_t y = *(const uint32_t*)b;
+	return (x > y) - (x < y);
+}
+
+static void
+make_year(struct bizcal_yr_s *restrict r, unsigned int y, uint32_t cum)
+{
+/* weekdays minus holidays, in native endianness */
+	const unsigned int ndays = 365U + leapp(y);
+	const unsigned int wd01 = get_jan01_wday(y);
+	const uint32_t *h, *const eh = hols + holi;
+	uint32_t key = y * 512U;
+	unsigned int n = 0U;
+
+	memset(r, 0, sizeof(*r));
+	for (unsigned int i = 0U; i < ndays; i++) {
+		const unsigned int wd = (wd01 + i) % 7U;
+
+		if (wd != 0U && wd != 6U) {
+			r->msk[i / 64U] |= 1ULL << (i % 64U);
+		}
+	}
+	/* kick holidays */
+	for (h = hols; h < eh && *h <= key; h++);
+	for (key += 512U; h < eh && *h < key; h++) {
+		const unsigned int i = (*h % 512U) - 1U;
+		r->msk[i / 64U] &= ~(1ULL << (i % 64U));
+	}
+	/* prefix sums */
+	for (size_t j = 0U; j < countof(r->msk); j++) {
+		r->pfx[j] = (uint16_t)n;
+		n += __builtin_popcountll(r->msk[j]);
+	}
+	r->cum = cum;
+	return;
+}
+#endif	/* STANDALONE */
+
+
+#if defined STANDALONE
+#include "bizcal.yucc"
+
+static int
+cmd_cc(const struct yuck_cmd_cc_s argi[static 1U])
+{
+	const char *outf;
+	unsigned int from, till;
+	int rc = 0;
+	int ofd;
+
+	for (size_t i = 0U; i < argi->nargs || i == 0U; i++) {
+		if (parse_file(argi->args[i]) < 0) {
+			error("cannot read file `%s'", argi->args[i] ?: "stdin");
+			rc = 1;
+		}
+	}
+	if (rc) {
+		goto out;
+	}
+	/* sort them, makes kicking holidays easier */
+	qsort(hols, holi, sizeof(*hols), hol_cmp);
+
+	from = holi ? hols[0U] / 512U : 0U;
+	till = holi ? hols[holi - 1U] / 512U : 0U;
+	if (argi->from_arg) {
+		from = strtoul(argi->from_arg, NULL, 10);
+	}
+	if (argi->till_arg) {
+		till = strtoul(argi->till_arg, NULL, 10);
+	}
+	if (from < 1U || till > 9999U || till < from) {
+		error("Error: invalid year range %u-%u", from, till);
+		rc = 1;
+		goto out;
+	}
+
+	if ((outf = argi->output_arg ?: "bizcal.bzc", false)) {
+		;
+	} else if ((ofd = open(outf, O_RDWR | O_CREAT | O_TRUNC, 0666)) < 0) {
+		serror("cannot open output file `%s'", outf);
+		rc = 1;
+		goto out;
+	}
+
+	/* generate a disk version now */
+	{
+		static struct bizcal_s c = {.magic = BZC_MAGIC};
+		uint32_t cum = 0U;
+		ssize_t sz;
+
+		c.y0 = htobe16((uint16_t)from);
+		c.ny = htobe16((uint16_t)(till - from + 1U));
+		if (sz = sizeof(c), write(ofd, &c, sz) < sz) {
+			goto trunc;
+		}
+		for (unsigned int y = from; y <= till; y++) {
+			struct bizcal_yr_s r;
+			const uint32_t ycum = cum;
+
+			make_year(&r, y, cum);
+			cum += r.pfx[5U] + __builtin_popcountll(r.msk[5U]);
+			/* big-endian on disk */
+			for (size_t j = 0U; j < countof(r.msk); j++) {
+				r.msk[j] = htobe64(r.msk[j]);
+				r.pfx[j] = htobe16(r.pfx[j]);
+			}
+			r.cum = htobe32(ycum);
+			if (sz = sizeof(r), write(ofd, &r, sz) < sz) {
+				goto trunc;
+			}
+		}
+		close(ofd);
+		goto out;
+
+	trunc:
+		/* some write failed, leave a 0 byte file around */
+		close(ofd);
+		unlink(outf);
+		rc = 1;
+	}
+
+out:
+	free(hols);
+	return rc;
+}
+
+static int
+cmd_show(const struct yuck_cmd_show_s argi[static 1U])
+{
+	const char *fn;
+	bizcal_t c;
+
+	if ((fn = argi->calendar_arg ?: "bizcal.bzc", false)) {
+		;
+	} else if ((c = bzc_open(fn)) == NULL) {
+		serror("cannot open input file `%s'", fn);
+		return 1;
+	}
+
+	/* print all weekdays that aren't business days */
+	for (unsigned int y = c->y0; y < c->y0 + c->ny; y++) {
+		const unsigned int ndays = 365U + leapp(y);
+		const unsigned int wd01 = get_jan01_wday(y);
+
+		for (unsigned int yd = 1U; yd <= ndays; yd++) {
+			const unsigned int wd = (wd01 + yd - 1U) % 7U;
+			unsigned int md;
+
+			if (wd == 0U || wd == 6U || bzc_bdayp(c, y, yd)) {
+				continue;
+			}
+			md = get_md(y, yd);
+			printf("%04u-%02u-%02u\n", y, md / 32U, md % 32U);
+		}
+	}
+
+	/* and off we go */
+	bzc_close(c);
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	yuck_t argi[1U];
+	int rc = 0;
+
+	if (yuck_parse(argi, argc, argv) < 0) {
+		rc = 1;
+		goto out;
+	}
+
+	switch (argi->cmd) {
+	case BIZCAL_CMD_CC:
+		rc = cmd_cc((void*)argi);
+		break;
+	case BIZCAL_CMD_SHOW:
+		rc = cmd_show((void*)argi);
+		break;
+	default:
+		rc = 1;
+		break;
+	}
+
+out:
+	yuck_free(argi);
+	return rc;
+}
+#endif	/* STANDALONE */
+
+/* bizcal.c ends here */
@@ -0,0 +1,158 @@
+/*** bizcal.h -- business day calendars
+ *
+ * Copyright (C) 2019 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of dateutils.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_bizcal_h_
+#define INCLUDED_bizcal_h_
+
+#include <stdint.h>
+
+/*
+** Each file begins with. . .
+*/
+#define	BZC_MAGIC	"BZc1"
+
+typedef const struct bizcal_s *bizcal_t;
+
+/** one year's worth of business days */
+struct bizcal_yr_s {
+	/* bit D-1 is set iff day-of-year D is a business day */
+	uint64_t msk[6U];
+	/* number of business days in all years before this one */
+	uint32_t cum;
+	/* number of business days in msk[0U] .. msk[i - 1U] */
+	uint16_t pfx[6U];
+};
+
+/** disk representation of bzc files, all numbers big-endian */
+struct bizcal_s {
+	/* magic cookie, should be BZC_MAGIC */
+	const char magic[4U];
+	/* first year covered */
+	uint16_t y0;
+	/* number of years covered */
+	uint16_t ny;
+	/* to round to 16 bytes boundary, stores fd and file size */
+	uint32_t flags[2U];
+	/* NY years starting with Y0 */
+	struct bizcal_yr_s yrs[];
+};
+
+
+/* public API */
+extern bizcal_t bzc_open(const char *file);
+
+extern void bzc_close(bizcal_t);
+
+
+/* lookups, Y is the year and YD the day of the year (1-based) */
+static inline __attribute__((pure)) const struct bizcal_yr_s*
+bzc_year(bizcal_t c, unsigned int y)
+{
+	if (y < c->y0 || y >= c->y0 + c->ny) {
+		return NULL;
+	}
+	return c->yrs + (y - c->y0);
+}
+
+static inline __attribute__((pure)) int
+bzc_bdayp(bizcal_t c, unsigned int y, unsigned int yd)
+{
+/* return 1 if Y-YD is a business day, 0 if not, -1 if not covered */
+	const struct bizcal_yr_s *r = bzc_year(c, y);
+
+	if (r == NULL || yd - 1U >= 366U) {
+		return -1;
+	}
+	yd--;
+	return (r->msk[yd / 64U] >> (yd % 64U)) & 1U;
+}
+
+static inline __attribute__((pure)) int32_t
+bzc_rank(bizcal_t c, unsigned int y, unsigned int yd)
+{
+/* return the number of business days in C before Y-YD */
+	const struct bizcal_yr_s *r = bzc_year(c, y);
+	uint64_t m;
+
+	if (r == NULL || yd - 1U >= 366U) {
+		return -1;
+	}
+	yd--;
+	m = r->msk[yd / 64U] & ((1ULL << (yd % 64U)) - 1ULL);
+	return r->cum + r->pfx[yd / 64U] + __builtin_popcountll(m);
+}
+
+static inline int
+bzc_select(bizcal_t c, unsigned int *restrict y, unsigned int *restrict yd,
+	   int32_t rk)
+{
+/* find the RK-th (0-based) business day in C, put it into Y and YD */
+	size_t lo = 0U;
+	size_t hi = c->ny;
+	const struct bizcal_yr_s *r;
+	unsigned int w;
+	uint64_t m;
+
+	if (rk < 0 || !c->ny) {
+		return -1;
+	}
+	/* find the year, i.e. the last one whose cum is <= RK */
+	while (hi - lo > 1U) {
+		size_t mid = (lo + hi) / 2U;
+
+		if (c->yrs[mid].cum <= (uint32_t)rk) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+	r = c->yrs + lo;
+	rk -= r->cum;
+	/* find the word */
+	for (w = 5U; w > 0U && r->pfx[w] > (uint32_t)rk; w--);
+	rk -= r->pfx[w];
+	if (rk >= __builtin_popcountll(m = r->msk[w])) {
+		/* beyond the last year */
+		return -1;
+	}
+	/* and the bit, kick the lowest RK set bits */
+	for (; rk > 0; rk--, m &= m - 1U);
+	*y = c->y0 + lo;
+	*yd = w * 64U + __builtin_ctzll(m) + 1U;
+	return 0;
+}
+
+#endif	/* INCLUDED_bizcal_h_ */
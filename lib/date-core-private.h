@@ -108,4 +108,15 @@ extern __attribute__((pure)) dt_yd_t __yd_fixup(dt_yd_t);
 extern __attribute__((pure)) dt_ymcw_t __ymcw_fixup(dt_ymcw_t);
 extern __attribute__((pure)) dt_bizda_t __bizda_fixup(dt_bizda_t);
 
+/* sort keys, seconds since the daisy epoch biased by SORTKEY_BIAS go
+ * into the upper 40 bits, 100ns ticks into the lower 24 */
+#define SORTKEY_TICKS	(24U)
+#define SORTKEY_BIAS	((int64_t)1 << 39U)
+
+static inline __attribute__((const)) uint64_t
+__sortkey(int64_t s, uint32_t ns)
+{
+	return (uint64_t)(s + SORTKEY_BIAS) << SORTKEY_TICKS | ns / 100U;
+}
+
 #endif	/* INCLUDED_date_core_private_h_ */
@@ -658,10 +658,10 @@ __strfd_card(
 				3 - (s.pad == DT_SPPAD_OMIT) << 1U, padchar(s));
 			break;
 		case DT_LDN:
-			res = snprintf(buf, bsz, "%u", that.ldn);
+			res = ui64tostr(buf, bsz, that.ldn);
 			break;
 		case DT_JDN:
-			res = snprintf(buf, bsz, "%.6f", that.jdn);
+			res = fix6tostr(buf, bsz, (double)that.jdn);
 			break;
 		default:
 			break;
@@ -743,7 +743,7 @@ __strfd_dur(
 		break;
 	case DT_SPFL_N_DSTD:
 	case DT_SPFL_N_DCNT_MON:
-		res = snprintf(buf, bsz, "%d", d->sd);
+		res = si64tostr(buf, bsz, d->sd);
 		break;
 	case DT_SPFL_N_YEAR:
 		if (!d->y) {
@@ -752,10 +752,10 @@ __strfd_dur(
 			d->y = __uidiv(d->m, GREG_MONTHS_P_YEAR);
 			d->m = __uimod(d->m, GREG_MONTHS_P_YEAR);
 		}
-		res = snprintf(buf, bsz, "%d", d->y);
+		res = si64tostr(buf, bsz, d->y);
 		break;
 	case DT_SPFL_N_MON:
-		res = snprintf(buf, bsz, "%d", d->m);
+		res = si64tostr(buf, bsz, d->m);
 		break;
 	case DT_SPFL_N_DCNT_WEEK:
 		if (!d->w) {
@@ -764,10 +764,10 @@ __strfd_dur(
 			d->w = __uidiv(d->d, GREG_DAYS_P_WEEK);
 			d->d = __uimod(d->d, GREG_DAYS_P_WEEK);
 		}
-		res = snprintf(buf, bsz, "%d", d->w);
+		res = si64tostr(buf, bsz, d->w);
 		break;
 	case DT_SPFL_N_WCNT_MON:
-		res = snprintf(buf, bsz, "%d", d->c);
+		res = si64tostr(buf, bsz, d->c);
 		break;
 	case DT_SPFL_S_WDAY:
 	case DT_SPFL_S_MON:
@@ -54,6 +54,7 @@
 #include "strops.h"
 #include "token.h"
 #include "nifty.h"
+#include "bizcal.h"
 /* parsers and formatters */
 #include "date-core-strpf.h"
 
@@ -467,6 +468,48 @@ dt_conv_to_daisy(struct dt_d_s that)
 	return (dt_daisy_t)0;
 }
 
+
+/* holiday calendars */
+static bizcal_t bizcal;
+
+DEFUN void
+dt_set_bizcal(bizcal_t c)
+{
+	bizcal = c;
+	return;
+}
+
+static int32_t
+__daisy_bzc_rank(dt_daisy_t d)
+{
+	unsigned int y = __daisy_get_year(d);
+	unsigned int yd = d - __jan00_daisy(y);
+
+	return bzc_rank(bizcal, y, yd);
+}
+
+static int
+__daisy_bzc_add_b(dt_daisy_t *restrict d, int n)
+{
+/* add N business days to D according to the holiday calendar,
+ * return -1 if D or the result isn't covered by the calendar */
+	unsigned int y = __daisy_get_year(*d);
+	unsigned int yd = *d - __jan00_daisy(y);
+	int32_t rk;
+
+	if (UNLIKELY((rk = bzc_rank(bizcal, y, yd)) < 0)) {
+		return -1;
+	} else if (n > 0 && !bzc_bdayp(bizcal, y, yd)) {
+		/* the next business day counts as the first one */
+		rk--;
+	}
+	if (UNLIKELY(bzc_select(bizcal, &y, &yd, rk + n) < 0)) {
+		return -1;
+	}
+	*d = __jan00_daisy(y) + yd;
+	return 0;
+}
+
 static dt_ymd_t
 dt_conv_to_ymd(struct dt_d_s that)
 {
@@ -1417,6 +1460,88 @@ dt_dconv(dt_dtyp_t tgttyp, struct dt_d_s d)
 	return res;
 }
 
+/* batch conversions, one loop per (source, target) pair so that
+ * dt_dconv()'s dispatch on types is paid once per run of dates */
+typedef void(*__dconv_n_f)(struct dt_d_s*, const struct dt_d_s*, size_t);
+
+#define __daisy_fixup(x)	(x)
+#define __ymd_to_ymd(x)		(x)
+#define __ymcw_to_ymcw(x)	(x)
+#define __ywd_to_ywd(x)		(x)
+#define __yd_to_yd(x)		(x)
+#define __daisy_to_daisy(x)	(x)
+
+/* call X(S, s, T, t) for every target type T of source S */
+#define DCONV_TGTS(X, S, s)			\
+	X(S, s, YMD, ymd)			\
+	X(S, s, YMCW, ymcw)			\
+	X(S, s, YWD, ywd)			\
+	X(S, s, YD, yd)				\
+	X(S, s, DAISY, daisy)
+
+#define DCONV_N(S, s, T, t)						\
+static void								\
+__dconv_##s##_##t(struct dt_d_s *out, const struct dt_d_s *in, size_t n) \
+{									\
+	for (size_t i = 0U; i < n; i++) {				\
+		const dt_##s##_t x = __##s##_fixup(in[i].s);		\
+		struct dt_d_s res = {.typ = DT_##T};			\
+									\
+		res.t = __##s##_to_##t(x);				\
+		out[i] = res;						\
+	}								\
+	return;								\
+}
+DCONV_TGTS(DCONV_N, YMD, ymd)
+DCONV_TGTS(DCONV_N, YMCW, ymcw)
+DCONV_TGTS(DCONV_N, YWD, ywd)
+DCONV_TGTS(DCONV_N, YD, yd)
+DCONV_TGTS(DCONV_N, DAISY, daisy)
+#undef DCONV_N
+
+#define DCONV_TBL(S, s, T, t)	[DT_##T] = __dconv_##s##_##t,
+static const __dconv_n_f dconv_n_tbl[DT_NDTYP][DT_NDTYP] = {
+	[DT_YMD] = {DCONV_TGTS(DCONV_TBL, YMD, ymd)},
+	[DT_YMCW] = {DCONV_TGTS(DCONV_TBL, YMCW, ymcw)},
+	[DT_YWD] = {DCONV_TGTS(DCONV_TBL, YWD, ywd)},
+	[DT_YD] = {DCONV_TGTS(DCONV_TBL, YD, yd)},
+	[DT_DAISY] = {DCONV_TGTS(DCONV_TBL, DAISY, daisy)},
+};
+#undef DCONV_TBL
+#undef DCONV_TGTS
+
+#undef __daisy_fixup
+#undef __ymd_to_ymd
+#undef __ymcw_to_ymcw
+#undef __ywd_to_ywd
+#undef __yd_to_yd
+#undef __daisy_to_daisy
+
+DEFUN void
+dt_dconv_n(dt_dtyp_t tgttyp, struct dt_d_s *out, const struct dt_d_s *in, size_t n)
+{
+	for (size_t i = 0U, j; i < n; i = j) {
+		const dt_dtyp_t srctyp = (dt_dtyp_t)in[i].typ;
+		__dconv_n_f f = NULL;
+
+		/* find the run of dates of the same type */
+		for (j = i + 1U; j < n && in[j].typ == srctyp; j++);
+
+		if (LIKELY(srctyp < DT_NDTYP && tgttyp < DT_NDTYP)) {
+			f = dconv_n_tbl[srctyp][tgttyp];
+		}
+		if (LIKELY(f != NULL)) {
+			f(out + i, in + i, j - i);
+		} else {
+			/* no direct converter, go the scenic route */
+			for (; i < j; i++) {
+				out[i] = dt_dconv(tgttyp, in[i]);
+			}
+		}
+	}
+	return;
+}
+
 DEFUN struct dt_d_s
 dt_dadd_d(struct dt_d_s d, int n)
 {
@@ -1496,6 +1621,18 @@ dt_dadd_b(struct dt_d_s d, int n)
 	if (UNLIKELY(!n)) {
 		/* cacn't use short-cut return here, it'd upset the IPO/LTO */
 		goto out;
+	} else if (bizcal != NULL && d.typ != DT_BIZDA) {
+		/* try the holiday calendar first, bizdas keep counting
+		 * business days in their own (weekend only) way */
+		dt_daisy_t dd = dt_conv_to_daisy(d);
+
+		if (__daisy_bzc_add_b(&dd, n) >= 0) {
+			struct dt_d_s tmp = {.typ = DT_DAISY};
+
+			tmp.daisy = dd;
+			d = dt_dconv(d.typ, tmp);
+			goto out;
+		}
 	}
 	switch (d.typ) {
 	case DT_JDN:
@@ -1809,6 +1946,17 @@ dt_ddiff(dt_durtyp_t tgttyp, struct dt_d_s d1, struct dt_d_s d2)
 		res = __daisy_diff(tmp1, tmp2);
 
 		/* fix up result in case it's bizsi, i.e. kick weekends */
+		if (tgttyp == DT_DURBD && bizcal != NULL) {
+			/* count business days in (d1, d2] like below */
+			int32_t r1 = __daisy_bzc_rank(tmp1 + 1);
+			int32_t r2 = __daisy_bzc_rank(tmp2 + 1);
+
+			if (r1 >= 0 && r2 >= 0) {
+				/* kick weekends and holidays */
+				res.dv = r2 - r1;
+				break;
+			}
+		}
 		if (tgttyp == DT_DURBD) {
 			dt_dow_t wdb = __daisy_get_wday(tmp2);
 			res.dv = __get_nbdays(res.dv, wdb);
@@ -1879,6 +2027,18 @@ dt_dcmp(struct dt_d_s d1, struct dt_d_s d2)
 	}
 }
 
+DEFUN uint64_t
+dt_dsortkey(struct dt_d_s d)
+{
+	dt_daisy_t dd;
+
+	if (UNLIKELY((dd = dt_conv_to_daisy(d)) == 0U)) {
+		return 0U;
+	}
+	/* 86400 seconds per day */
+	return __sortkey((int64_t)dd * 86400, 0U);
+}
+
 DEFUN int
 dt_d_in_range_p(struct dt_d_s d, struct dt_d_s d1, struct dt_d_s d2)
 {
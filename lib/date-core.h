@@ -418,6 +418,13 @@ extern struct dt_d_s dt_date(dt_dtyp_t outtyp);
  * Convert D to another calendric system, specified by TGTTYP. */
 extern struct dt_d_s dt_dconv(dt_dtyp_t tgttyp, struct dt_d_s);
 
+/**
+ * Convert N dates IN to TGTTYP, storing them in OUT, which may be IN.
+ * Results are those of dt_dconv(), runs of dates of the same type
+ * between ymd, ymcw, ywd, yd and daisy are converted in one go. */
+extern void
+dt_dconv_n(dt_dtyp_t tgttyp, struct dt_d_s *out, const struct dt_d_s *in, size_t n);
+
 /**
  * Get the year count (gregorian) of a date,
  * calendars without the notion of a year will return 0. */
@@ -471,6 +478,12 @@ extern dt_daisy_t dt_conv_to_daisy(struct dt_d_s);
 
 extern dt_ymd_t __daisy_to_ymd(dt_daisy_t);
 
+/**
+ * Use holiday calendar C (see bizcal.h) for business day arithmetic,
+ * NULL to count weekends only. */
+struct bizcal_s;
+extern void dt_set_bizcal(const struct bizcal_s *c);
+
 /* adders */
 /**
  * Add duration DUR to date D. */
@@ -532,6 +545,13 @@ extern int dt_dcmp(struct dt_d_s d1, struct dt_d_s d2);
  * 1 if D1 is younger than the D2. */
 extern int dt_d_in_range_p(struct dt_d_s d, struct dt_d_s d1, struct dt_d_s d2);
 
+/**
+ * Return an integer for D that orders like D regardless of its type,
+ * i.e. dates of different calendars can be compared arithmetically.
+ * Keys of dates agree with dt_sortkey() of date-only dt_dt_s objects.
+ * Unknown dates yield 0 which sorts before everything else. */
+extern __attribute__((pure)) uint64_t dt_dsortkey(struct dt_d_s d);
+
 #if defined LIBDUT
 /**
  * Return the base date/time as struct dt_d_s.
@@ -208,9 +208,24 @@ try_time:
 		d.st.s = 0;
 	} else if (*sp != '.') {
 		goto eval_time;
-	} else if ((sp++, d.st.ns = strtoi_lim(sp, &sp, 0, 999999999)) < 0) {
-		d.st.ns = 0;
-		goto eval_time;
+	} else {
+		/* fractional seconds, scaled to nanoseconds, digits beyond
+		 * the ninth are dropped */
+		const char *fp = ++sp;
+
+		for (; *sp >= '0' && *sp <= '9'; sp++) {
+			if (sp - fp < 9) {
+				d.st.ns = d.st.ns * 10 + (*sp - '0');
+			}
+		}
+		if (UNLIKELY(sp == fp)) {
+			/* just a dot, leave it */
+			sp--;
+		} else {
+			for (ptrdiff_t i = sp - fp; i < 9; i++) {
+				d.st.ns *= 10;
+			}
+		}
 	}
 eval_time:
 	if (UNLIKELY(d.st.h == 24)) {
@@ -222,6 +237,7 @@ eval_time:
 	res.t.hms.h = d.st.h;
 	res.t.hms.m = d.st.m;
 	res.t.hms.s = d.st.s;
+	res.t.hms.ns = d.st.ns;
 	if (res.d.typ > DT_DUNK) {
 		const char *tp;
 		dt_make_sandwich(&res, res.d.typ, DT_HMS);
@@ -361,7 +377,7 @@ __strfdt_card(
 	case DT_SPFL_N_EPOCH: {
 		/* convert to sexy */
 		int64_t sexy = dt_conv_to_sexy(that).sexy;
-		res = snprintf(buf, bsz, "%" PRIi64, sexy);
+		res = si64tostr(buf, bsz, sexy);
 		break;
 	}
 
@@ -373,9 +389,14 @@ __strfdt_card(
 			z = -z;
 			sign = '-';
 		}
-		res = snprintf(
-			buf, bsz, "%c%02u:%02u",
-			sign, (uint32_t)z / 3600U, ((uint32_t)z / 60U) % 60U);
+		if (UNLIKELY(bsz < 6U)) {
+			break;
+		}
+		buf[res++] = sign;
+		res += ui99topstr(buf + res, 2U, (uint32_t)z / 3600U, 2U, '0');
+		buf[res++] = ':';
+		res += ui99topstr(
+			buf + res, 2U, ((uint32_t)z / 60U) % 60U, 2U, '0');
 		break;
 	}
 
@@ -395,6 +416,19 @@ __strfdt_card(
 	return res;
 }
 
+static size_t
+__strf_dur(char *restrict buf, size_t bsz, int64_t dv, const char *unit)
+{
+/* print DV followed by UNIT, like "%" PRIi64 "s" */
+	size_t res = si64tostr(buf, bsz, dv);
+
+	for (; res && *unit && res < bsz; buf[res++] = *unit++);
+	if (res < bsz) {
+		buf[res] = '\0';
+	}
+	return res;
+}
+
 DEFUN size_t
 __strfdt_dur(
 	char *buf, size_t bsz, struct dt_spec_s s,
@@ -439,13 +473,7 @@ __strfdt_dur(
 			dv *= SECS_PER_MIN;
 			/*@fallthrough@*/
 		case DT_DURS:
-			if (LIKELY(!that.tai)) {
-				return (size_t)snprintf(
-					buf, bsz, "%" PRIi64 "s", dv);
-			} else {
-				return (size_t)snprintf(
-					buf, bsz, "%" PRIi64 "rs", dv);
-			}
+			return __strf_dur(buf, bsz, dv, that.tai ? "rs" : "s");
 			break;
 		}
 		break;
@@ -458,13 +486,7 @@ __strfdt_dur(
 			dur *= NANOS_PER_SEC;
 			/*@fallthrough@*/
 		case DT_DURNANO:
-			if (LIKELY(!that.tai)) {
-				return (size_t)snprintf(
-					buf, bsz, "%" PRIi64 "ns", dur);
-			} else {
-				return (size_t)snprintf(
-					buf, bsz, "%" PRIi64 "rns", dur);
-			}
+			return __strf_dur(buf, bsz, dur, that.tai ? "rns" : "ns");
 		default:
 			break;
 		}
@@ -499,13 +521,13 @@ __strfdt_xdn(char *buf, size_t bsz, struct dt_dt_s that)
 	case DT_LDN:
 		dn = (double)that.d.ldn;
 		if (dt_sandwich_only_d_p(that)) {
-			return snprintf(buf, bsz, "%.0f", dn);
+			return ui64tostr(buf, bsz, that.d.ldn);
 		}
 		break;
 	case DT_MDN:
 		dn = (double)that.d.mdn;
 		if (dt_sandwich_only_d_p(that)) {
-			return snprintf(buf, bsz, "%.0f", dn);
+			return ui64tostr(buf, bsz, that.d.mdn);
 		}
 		break;
 	default:
@@ -516,7 +538,7 @@ __strfdt_xdn(char *buf, size_t bsz, struct dt_dt_s that)
 		unsigned int ss = __secs_since_midnight(that.t);
 		dn += (double)ss / (double)SECS_PER_DAY;
 	}
-	return snprintf(buf, bsz, "%.6f", dn);
+	return fix6tostr(buf, bsz, dn);
 }
 
 #endif	/* INCLUDED_dt_core_strpf_c_ */
@@ -122,6 +122,24 @@ struct strpdti_s {
 # error daisy unix and gps bases diverge
 #endif	/* static assert */
 
+static inline dt_ssexy_t
+__nsexy_s(dt_nsexy_t nx)
+{
+/* floored seconds of NX */
+	const dt_nsexy_t s = nx / (dt_nsexy_t)NANOS_PER_SEC;
+
+	return s - (nx % (dt_nsexy_t)NANOS_PER_SEC < 0);
+}
+
+static inline int32_t
+__nsexy_ns(dt_nsexy_t nx)
+{
+/* nanoseconds of NX past its floored second */
+	const int32_t ns = (int32_t)(nx % (dt_nsexy_t)NANOS_PER_SEC);
+
+	return ns < 0 ? ns + (int32_t)NANOS_PER_SEC : ns;
+}
+
 static inline dt_ssexy_t
 __to_unix_epoch(struct dt_dt_s dt)
 {
@@ -132,6 +150,8 @@ __to_unix_epoch(struct dt_dt_s dt)
 	if (dt.typ == DT_SEXY) {
 		/* no way to find out, is there */
 		return dt.sexy;
+	} else if (dt.typ == DT_NSEXY) {
+		return __nsexy_s(dt.nsexy);
 	} else if (dt_sandwich_p(dt) || dt_sandwich_only_d_p(dt)) {
 		dd = dt.d;
 	} else if (dt_sandwich_only_t_p(dt)) {
@@ -151,12 +171,36 @@ dt_to_unix_epoch(struct dt_dt_s dt)
 	return __to_unix_epoch(dt);
 }
 
+static inline dt_nsexy_t
+__to_unix_nsepoch(struct dt_dt_s dt)
+{
+	if (dt.typ == DT_NSEXY) {
+		return dt.nsexy;
+	} else if (dt.typ == DT_SEXY) {
+		return (dt_nsexy_t)dt.sxepoch * (dt_nsexy_t)NANOS_PER_SEC;
+	} else if (dt_sandwich_p(dt) || dt_sandwich_only_t_p(dt)) {
+		return __to_unix_epoch(dt) * (dt_nsexy_t)NANOS_PER_SEC +
+			dt.t.hms.ns;
+	}
+	return __to_unix_epoch(dt) * (dt_nsexy_t)NANOS_PER_SEC;
+}
+
+/* public version */
+dt_nsexy_t
+dt_to_unix_nsepoch(struct dt_dt_s dt)
+{
+	return __to_unix_nsepoch(dt);
+}
+
 static inline dt_ssexy_t
 __to_gps_epoch(struct dt_dt_s dt)
 {
 	if (dt.typ == DT_SEXY) {
 		/* no way to find out, is there */
 		return dt.sexy;
+	} else if (dt.typ == DT_NSEXY) {
+		/* same here */
+		return __nsexy_s(dt.nsexy);
 	} else if (dt_sandwich_p(dt) || dt_sandwich_only_d_p(dt)) {
 		dt_daisy_t d = dt_conv_to_daisy(dt.d);
 		dt_ssexy_t res = (d - DAISY_GPS_BASE) * SECS_PER_DAY;
@@ -180,6 +224,11 @@ dt_conv_to_sexy(struct dt_dt_s dt)
 {
 	if (dt.typ == DT_SEXY) {
 		return dt;
+	} else if (dt.typ == DT_NSEXY) {
+		const dt_ssexy_t sx = __nsexy_s(dt.nsexy);
+
+		dt.nsexy = 0;
+		dt.sxepoch = sx;
 	} else if (dt_sandwich_only_t_p(dt)) {
 		dt.sxepoch = (dt.t.hms.h * 60 + dt.t.hms.m) * 60 + dt.t.hms.s;
 	} else if (dt_sandwich_p(dt) || dt_sandwich_only_d_p(dt)) {
@@ -212,6 +261,34 @@ __sexy_to_daisy(dt_ssexy_t sx)
 	return res;
 }
 
+static inline struct dt_dt_s
+__nsexy_to_daisy(dt_nsexy_t nx)
+{
+	struct dt_dt_s res = {DT_UNK};
+	dt_ssexy_t sx = __nsexy_s(nx);
+	dt_ssexy_t dd = sx / (dt_ssexy_t)SECS_PER_DAY;
+	int32_t ss = (int32_t)(sx % (dt_ssexy_t)SECS_PER_DAY);
+
+	if (ss < 0) {
+		/* floor it */
+		ss += SECS_PER_DAY;
+		dd--;
+	}
+	res.t.hms.ns = __nsexy_ns(nx);
+	res.t.hms.s = ss % SECS_PER_MIN;
+	ss /= SECS_PER_MIN;
+	res.t.hms.m = ss % MINS_PER_HOUR;
+	ss /= MINS_PER_HOUR;
+	res.t.hms.h = ss;
+
+	/* rest is a day-count, move to daisy */
+	res.d.daisy = dd + DAISY_UNIX_BASE;
+
+	/* sandwichify */
+	dt_make_sandwich(&res, DT_DAISY, DT_HMS);
+	return res;
+}
+
 static inline struct dt_dt_s
 __ymdhms_to_ymd(dt_ymdhms_t x)
 {
@@ -499,55 +576,33 @@ static zidx_t
 leaps_before(struct dt_dt_s d)
 {
 	zidx_t res;
-	bool on;
 
 	switch (d.typ) {
 	case DT_YMD:
-		res = leaps_before_ui32(leaps_ymd, nleaps, d.d.ymd.u);
-		on = res + 1 < nleaps && leaps_ymd[res + 1] == d.d.ymd.u;
-		break;
 	case DT_YMCW:
-		res = leaps_before_ui32(leaps_ymcw, nleaps, d.d.ymcw.u);
-		on = res + 1 < nleaps && leaps_ymcw[res + 1] == d.d.ymcw.u;
-		break;
-	case DT_DAISY:
-		res = leaps_before_ui32(leaps_d, nleaps, d.d.daisy);
-		on = res + 1 < nleaps && leaps_d[res + 1] == d.d.daisy;
+	case DT_DAISY: {
+		/* one combined key, a transition on the very same day only
+		 * counts if we're a sandwich past its time */
+		uint64_t key = (uint64_t)dt_conv_to_daisy(d.d) << 24U;
+
+		if (dt_sandwich_p(d)) {
+			key |= d.t.hms.u24;
+		}
+		res = leaps_rank_ui64(leaps_dhms, nleaps_dhms, key);
 		break;
+	}
 	case DT_SEXY:
 	case DT_SEXYTAI:
 		res = leaps_before_si32(leaps_s, nleaps, (int32_t)d.sexy);
-		on = (res + 1U < nleaps) &&
-			(leaps_s[res + 1] == (int32_t)d.sexy);
+		break;
+	case DT_NSEXY:
+		res = leaps_before_si32(
+			leaps_s, nleaps, (int32_t)__nsexy_s(d.nsexy));
 		break;
 	default:
 		res = 0;
-		on = false;
 		break;
 	}
-
-	/* clang 3.3 will fuck the following up
-	 * see http://llvm.org/bugs/show_bug.cgi?id=18028
-	 * we have to access d.t.hms.u24 once (the failing access),
-	 * then again and magically it'll work, thanks a bunch clang! */
-	if (dt_sandwich_p(d) && on) {
-#if defined __clang__ && __clang_major__ == 3 && __clang_minor__ >= 3
-# warning clang bug! \
-see http://llvm.org/bugs/show_bug.cgi?id=18028
-		/* access d.t.hms.u24 once */
-		volatile unsigned int hms = d.t.hms.u24;
-
-		/* check the time part too */
-		if ((hms & 0xffffffU) > leaps_hms[res + 1]) {
-			res++;
-		}
-#else  /* !__clang__ 3.3 */
-		/* check the time part too */
-		if (d.t.hms.u24 > leaps_hms[res + 1]) {
-			res++;
-		}
-#endif	/* __clang__ 3.3 */
-	}
 	return res;
 }
 #endif	/* WITH_LEAP_SECONDS */
@@ -725,7 +780,11 @@ dt_strpdt(const char *str, const char *fmt, char **ep)
 		goto fucked;
 	}
 	/* check if it's a sexy type */
-	if (d.i) {
+	if (d.i && d.st.ns) {
+		/* epoch with nanoseconds */
+		res.typ = DT_NSEXY;
+		res.nsexy = d.i * (dt_nsexy_t)NANOS_PER_SEC + d.st.ns;
+	} else if (d.i) {
 		res.typ = DT_SEXY;
 		res.sexy = d.i;
 	} else {
@@ -919,6 +978,7 @@ dt_strfdt(char *restrict buf, size_t bsz, const char *fmt, struct dt_dt_s that)
 		break;
 
 	case DT_SEXY:
+	case DT_NSEXY:
 		/* instead of leaving this as SEXY turn it into
 		 * DAISY/HMS sandwich */
 		that = dt_dtconv((dt_dttyp_t)DT_DAISY, that);
@@ -1364,6 +1424,10 @@ dt_datetime(dt_dttyp_t outtyp)
 		res.t.hms.s = tm.tm_sec;
 		res.t.hms.ns = tv.tv_usec * 1000;
 		dt_make_sandwich(&res, (dt_dtyp_t)outtyp, DT_HMS);
+	} else if (outtyp == DT_NSEXY) {
+		res.typ = DT_NSEXY;
+		res.nsexy = (dt_nsexy_t)tv.tv_sec * (dt_nsexy_t)NANOS_PER_SEC +
+			tv.tv_usec * 1000;
 	} else {
 		/* must be one of the sexies then, aye? */
 		res.sexy = tv.tv_sec;
@@ -1426,6 +1490,15 @@ dt_dtconv(dt_dttyp_t tgttyp, struct dt_dt_s d)
 			d.typ = tgttyp;
 			break;
 		}
+		case DT_NSEXY: {
+			const dt_nsexy_t nx = __to_unix_nsepoch(d);
+
+			d.sandwich = 0;
+			d.typ = DT_NSEXY;
+			d.u = 0U;
+			d.nsexy = nx;
+			break;
+		}
 		case DT_YMDHMS:
 			/* no support for this guy yet */
 
@@ -1448,6 +1521,23 @@ dt_dtconv(dt_dttyp_t tgttyp, struct dt_dt_s d)
 				d.sandwich = 1U;
 			} else if (tgttyp == DT_YMDHMS) {
 				;
+			} else if (tgttyp == DT_NSEXY) {
+				const dt_nsexy_t nx = (dt_nsexy_t)d.sxepoch *
+					(dt_nsexy_t)NANOS_PER_SEC;
+
+				d.typ = DT_NSEXY;
+				d.u = 0U;
+				d.nsexy = nx;
+			}
+			break;
+		case DT_NSEXY:
+			if (tgttyp > DT_UNK && tgttyp < DT_PACK) {
+				/* go through daisy */
+				d = __nsexy_to_daisy(d.nsexy);
+				d.d = dt_dconv((dt_dtyp_t)tgttyp, d.d);
+				d.sandwich = 1U;
+			} else if (tgttyp == DT_SEXY) {
+				d = dt_conv_to_sexy(d);
 			}
 			break;
 		case DT_YMDHMS:
@@ -1458,6 +1548,9 @@ dt_dtconv(dt_dttyp_t tgttyp, struct dt_dt_s d)
 				d.sandwich = 1U;
 			} else if (tgttyp == DT_SEXY) {
 				;
+			} else if (tgttyp == DT_NSEXY) {
+				d = __ymdhms_to_ymd(d.ymdhms);
+				d = dt_dtconv(DT_NSEXY, d);
 			}
 			break;
 		default:
@@ -1471,6 +1564,46 @@ dt_dtconv(dt_dttyp_t tgttyp, struct dt_dt_s d)
 	return d;
 }
 
+static struct dt_dt_s
+__nsexy_add(struct dt_dt_s d, struct dt_dtdur_s dur)
+{
+/* like __sexy_add() but the calendric durations go through a sandwich */
+	dt_nsexy_t dv = dur.dv;
+
+	switch (dur.durtyp) {
+	case DT_DURH:
+		dv *= MINS_PER_HOUR;
+		/*@fallthrough@*/
+	case DT_DURM:
+		dv *= SECS_PER_MIN;
+		/*@fallthrough@*/
+	case DT_DURS:
+		dv *= NANOS_PER_SEC;
+		/*@fallthrough@*/
+	case DT_DURNANO:
+		break;
+	case DT_DURD:
+		dv = (dt_nsexy_t)dur.d.dv * SECS_PER_DAY;
+		/*@fallthrough@*/
+	case DT_DURUNK:
+		dv += dur.t.sdur;
+		dv *= NANOS_PER_SEC;
+		break;
+	default:
+		/* months, years, business days, etc. */
+		with (struct dt_dt_s tmp = __nsexy_to_daisy(d.nsexy)) {
+			tmp.d = dt_dconv(DT_YMD, tmp.d);
+			tmp = dt_dtadd(tmp, dur);
+			/* calendric arithmetic won't touch the nanoseconds */
+			d.nsexy = __to_unix_epoch(tmp) * (dt_nsexy_t)NANOS_PER_SEC +
+				__nsexy_ns(d.nsexy);
+		}
+		return d;
+	}
+	d.nsexy += dv;
+	return d;
+}
+
 DEFUN struct dt_dt_s
 dt_dtadd(struct dt_dt_s d, struct dt_dtdur_s dur)
 {
@@ -1492,6 +1625,9 @@ dt_dtadd(struct dt_dt_s d, struct dt_dtdur_s dur)
 	if (d.typ == DT_SEXY) {
 		d.sexy = __sexy_add(d.sexy, dur);
 		return d;
+	} else if (d.typ == DT_NSEXY) {
+		/* no decomposition, no carries */
+		return __nsexy_add(d, dur);
 	}
 
 	dv = dur.dv;
@@ -1586,12 +1722,50 @@ dt_dtadd(struct dt_dt_s d, struct dt_dtdur_s dur)
 	return d;
 }
 
+static struct dt_dtdur_s
+__nsexy_dur(dt_dtdurtyp_t tgttyp, dt_nsexy_t n1, dt_nsexy_t n2)
+{
+/* turn the nanosecond epochs N1 and N2 into a duration N2 - N1 of
+ * type TGTTYP */
+#define DV_MAX	((int64_t)1 << 47U)
+	struct dt_dtdur_s res = {(dt_dtdurtyp_t)DT_DURUNK};
+	const int64_t dns = n2 - n1;
+
+	if (tgttyp == DT_DURNANO && dns < DV_MAX && dns >= -DV_MAX) {
+		res.durtyp = DT_DURNANO;
+		res.dv = dns;
+	} else {
+		/* like dt_dtdiff() we hand out seconds for everything else,
+		 * and like dt_tdiff_s() we ignore sub-second parts */
+		res.durtyp = DT_DURS;
+		res.dv = __nsexy_s(n2) - __nsexy_s(n1);
+	}
+#undef DV_MAX
+	return res;
+}
+
 DEFUN struct dt_dtdur_s
 dt_dtdiff(dt_dtdurtyp_t tgttyp, struct dt_dt_s d1, struct dt_dt_s d2)
 {
 	struct dt_dtdur_s res = {(dt_dtdurtyp_t)DT_DURUNK};
 	int64_t dt = 0;
 
+	if (d1.typ == DT_NSEXY || d2.typ == DT_NSEXY) {
+		if ((dt_durtyp_t)tgttyp >= DT_NDURTYP &&
+		    tgttyp < DT_NDTDURTYP) {
+			/* stay in the nanosecond domain */
+			return __nsexy_dur(
+				tgttyp,
+				__to_unix_nsepoch(d1), __to_unix_nsepoch(d2));
+		}
+		/* calendric durations need calendric dates */
+		if (d1.typ == DT_NSEXY) {
+			d1 = dt_dtconv((dt_dttyp_t)DT_DAISY, d1);
+		}
+		if (d2.typ == DT_NSEXY) {
+			d2 = dt_dtconv((dt_dttyp_t)DT_DAISY, d2);
+		}
+	}
 	if (!dt_sandwich_only_d_p(d1) && !dt_sandwich_only_d_p(d2)) {
 		/* do the time portion difference right away */
 		switch (tgttyp) {
@@ -1694,8 +1868,19 @@ dt_dtdiff(dt_dtdurtyp_t tgttyp, struct dt_dt_s d1, struct dt_dt_s d2)
 DEFUN int
 dt_dtcmp(struct dt_dt_s d1, struct dt_dt_s d2)
 {
-/* for the moment D1 and D2 have to be of the same type. */
-	if (UNLIKELY(d1.typ != d2.typ)) {
+/* for the moment D1 and D2 have to be of the same type,
+ * unless one of them is a nanosecond epoch */
+	if (d1.typ == DT_NSEXY || d2.typ == DT_NSEXY) {
+		/* plain integers, how nice */
+		dt_nsexy_t n1, n2;
+
+		if (UNLIKELY(dt_unk_p(d1) || dt_unk_p(d2))) {
+			return -2;
+		}
+		n1 = __to_unix_nsepoch(d1);
+		n2 = __to_unix_nsepoch(d2);
+		return (n1 > n2) - (n1 < n2);
+	} else if (UNLIKELY(d1.typ != d2.typ)) {
 		/* always equal */
 		return -2;
 	}
@@ -1737,6 +1922,46 @@ try_time:
 	return 0;
 }
 
+DEFUN uint64_t
+dt_sortkey(struct dt_dt_s d)
+{
+	static const int64_t unix_base = DAISY_UNIX_BASE * SECS_PER_DAY;
+	int64_t s = 0;
+	uint32_t ns = 0U;
+
+	switch (d.typ) {
+	case DT_SEXY:
+	case DT_SEXYTAI:
+		return __sortkey(unix_base + d.sxepoch, 0U);
+	case DT_NSEXY:
+		return __sortkey(
+			unix_base + __nsexy_s(d.nsexy), __nsexy_ns(d.nsexy));
+	case DT_YMDHMS:
+		d = __ymdhms_to_ymd(d.ymdhms);
+		break;
+	default:
+		break;
+	}
+
+	if (dt_sandwich_p(d) || dt_sandwich_only_d_p(d)) {
+		const dt_daisy_t dd = dt_conv_to_daisy(d.d);
+
+		if (UNLIKELY(dd == 0U)) {
+			return 0U;
+		}
+		s = (int64_t)dd * SECS_PER_DAY;
+	} else if (!dt_sandwich_only_t_p(d)) {
+		/* unknown */
+		return 0U;
+	}
+	if (!dt_sandwich_only_d_p(d)) {
+		s += (d.t.hms.h * MINS_PER_HOUR + d.t.hms.m) * SECS_PER_MIN +
+			d.t.hms.s;
+		ns = d.t.hms.ns;
+	}
+	return __sortkey(s, ns);
+}
+
 DEFUN int
 dt_dt_in_range_p(struct dt_dt_s d, struct dt_dt_s d1, struct dt_dt_s d2)
 {
@@ -54,6 +54,8 @@ typedef enum {
 	DT_YMDHMS = DT_PACK,
 	DT_SEXY,
 	DT_SEXYTAI,
+	/* nanoseconds since 1970-01-01T00:00:00, not packed */
+	DT_NSEXY,
 	DT_NDTTYP,
 } dt_dttyp_t;
 
@@ -110,6 +112,10 @@ typedef uint64_t dt_sexy_t;
 typedef int64_t dt_ssexy_t;
 #define DT_SEXY_BASE_YEAR	(1917)
 
+/** nsexy
+ * nanoseconds since 1970-01-01T00:00:00, that's +/-292 years */
+typedef int64_t dt_nsexy_t;
+
 struct dt_dt_s {
 	union {
 		/* packs */
@@ -160,6 +166,12 @@ struct dt_dt_s {
 			struct dt_d_s d;
 			struct dt_t_s t;
 		};
+		/* nsexy, the flags are those of the packs above,
+		 * the value lives where the time of a sandwich would */
+		struct {
+			uint64_t:64;
+			dt_nsexy_t nsexy;
+		};
 	};
 };
 
@@ -287,6 +299,30 @@ dt_dtdiff(dt_dtdurtyp_t tgttyp, struct dt_dt_s d1, struct dt_dt_s d2);
  * 1 if D1 is younger than the D2. */
 extern int dt_dtcmp(struct dt_dt_s d1, struct dt_dt_s d2);
 
+/**
+ * Return an integer for D that orders like D regardless of its type,
+ * so date/times of different types compare (and hash) arithmetically.
+ * Keys resolve 100ns and cover +/-17000 years around the daisy base.
+ * Date-only objects key like midnight of that day, time-only objects
+ * key like that time on the (invalid) day 0 of the daisy calendar,
+ * leap seconds in TAI epochs are not accounted for.
+ * Unknown date/times yield 0 which sorts before everything else. */
+extern __attribute__((pure)) uint64_t dt_sortkey(struct dt_dt_s d);
+
+/**
+ * Hash a key as obtained by dt_sortkey() or dt_dsortkey().
+ * The finaliser of MurmurHash3, so all bits of the key matter. */
+static inline __attribute__((const)) uint64_t
+dt_sortkey_hash(uint64_t k)
+{
+	k ^= k >> 33U;
+	k *= 0xff51afd7ed558ccdULL;
+	k ^= k >> 33U;
+	k *= 0xc4ceb9fe1a85ec53ULL;
+	k ^= k >> 33U;
+	return k;
+}
+
 /**
  * Check if D is in the interval spanned by D1 and D2,
  * 1 if D1 is younger than the D2. */
@@ -302,6 +338,10 @@ extern dt_ssexy_t dt_to_unix_epoch(struct dt_dt_s);
  * Convert a dt_dt_s to an epoch difference, based on the GPS epoch. */
 extern dt_ssexy_t dt_to_gps_epoch(struct dt_dt_s);
 
+/**
+ * Convert a dt_dt_s to nanoseconds since the Unix epoch. */
+extern dt_nsexy_t dt_to_unix_nsepoch(struct dt_dt_s);
+
 /**
  * Set specific fallback date/time to use when input is underspecified.
  * Internally, when no default is set and input is underspecified  the
@@ -45,20 +45,29 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
+#if defined HAVE_SYS_STDINT_H
+# include <sys/stdint.h>
+#endif	/* HAVE_SYS_STDINT_H */
 #include <stdio.h>
 #include <string.h>
+#include <stdarg.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
 #include "dt-locale.h"
 #include "date-core.h"
 #include "date-core-strpf.h"
+#include "boops.h"
 #include "nifty.h"
 
 #if defined LOCALE_FILE
 static const char locfn[] = LOCALE_FILE;
+static const char loccfn[] = LOCALE_FILE ".dtl";
 #else  /* !LOCALE_FILE */
 static const char locfn[] = "locale";
+static const char loccfn[] = "locale.dtl";
 #endif	/* LOCALE_FILE */
 
 #if !defined DEFUN
@@ -72,7 +81,6 @@ struct lst_s {
 	const char *s[GREG_MONTHS_P_YEAR + 2U];
 	size_t min;
 	size_t max;
-	char str[];
 };
 
 struct loc_s {
@@ -82,6 +90,38 @@ struct loc_s {
 	struct lst_s *abbr_mon;
 };
 
+/*
+** Compiled locale files begin with. . .
+*/
+#define DTL_MAGIC	"DTl1"
+
+/** disk representation of one locale, all numbers big-endian */
+struct dtl_loc_s {
+	/* file offset of the locale name */
+	uint32_t name;
+	/* abbr_wday, long_wday, abbr_mon, long_mon, in file order */
+	struct dtl_lst_s {
+		/* file offsets of the names, unused slots are empty strings */
+		uint32_t s[GREG_MONTHS_P_YEAR + 2U];
+		/* lengths of the shortest and the longest name */
+		uint16_t min;
+		uint16_t max;
+	} lst[4U];
+};
+
+/** disk representation of dtl files, followed by the string pool */
+struct dtl_s {
+	/* magic cookie, should be DTL_MAGIC */
+	const char magic[4U];
+	/* number of locales */
+	uint32_t nloc;
+	/* NLOC locales, sorted by name */
+	struct dtl_loc_s loc[];
+};
+
+/* name lists pointing into a compiled locale file, input and format */
+static struct lst_s cloc[2U][4U];
+
 static const char *__long_wday[] = {
 	"Miracleday",
 	"Monday",
@@ -226,12 +266,22 @@ xmemmem(const char *hay, const size_t hayz, const char *ndl, const size_t ndlz)
 	return NULL;
 }
 
+static inline bool
+cclp(const char **s)
+{
+/* return true if S is one of the lists in CLOC, i.e. not malloc()'d */
+	const uintptr_t x = (uintptr_t)s;
+	const uintptr_t c = (uintptr_t)cloc;
+
+	return x >= c && x < c + sizeof(cloc);
+}
+
 
 /* locale business */
 static inline void
 __strp_reset_long_wday(void)
 {
-	if (dut_long_wday != __long_wday) {
+	if (dut_long_wday != __long_wday && !cclp(dut_long_wday)) {
 		free(deconst(dut_long_wday));
 	}
 	dut_long_wday = __long_wday;
@@ -242,7 +292,7 @@ __strp_reset_long_wday(void)
 static inline void
 __strp_reset_abbr_wday(void)
 {
-	if (dut_abbr_wday != __abbr_wday) {
+	if (dut_abbr_wday != __abbr_wday && !cclp(dut_abbr_wday)) {
 		free(deconst(dut_abbr_wday));
 	}
 	dut_abbr_wday = __abbr_wday;
@@ -253,7 +303,7 @@ __strp_reset_abbr_wday(void)
 static inline void
 __strp_reset_long_mon(void)
 {
-	if (dut_long_mon != __long_mon) {
+	if (dut_long_mon != __long_mon && !cclp(dut_long_mon)) {
 		free(deconst(dut_long_mon));
 	}
 	dut_long_mon = __long_mon;
@@ -264,7 +314,7 @@ __strp_reset_long_mon(void)
 static inline void
 __strp_reset_abbr_mon(void)
 {
-	if (dut_abbr_mon != __abbr_mon) {
+	if (dut_abbr_mon != __abbr_mon && !cclp(dut_abbr_mon)) {
 		free(deconst(dut_abbr_mon));
 	}
 	dut_abbr_mon = __abbr_mon;
@@ -311,7 +361,7 @@ __strp_set_abbr_mon(struct lst_s *new)
 static inline void
 __strf_reset_long_wday(void)
 {
-	if (duf_long_wday != __long_wday) {
+	if (duf_long_wday != __long_wday && !cclp(duf_long_wday)) {
 		free(deconst(duf_long_wday));
 	}
 	duf_long_wday = __long_wday;
@@ -321,7 +371,7 @@ __strf_reset_long_wday(void)
 static inline void
 __strf_reset_abbr_wday(void)
 {
-	if (duf_abbr_wday != __abbr_wday) {
+	if (duf_abbr_wday != __abbr_wday && !cclp(duf_abbr_wday)) {
 		free(deconst(duf_abbr_wday));
 	}
 	duf_abbr_wday = __abbr_wday;
@@ -331,7 +381,7 @@ __strf_reset_abbr_wday(void)
 static inline void
 __strf_reset_long_mon(void)
 {
-	if (duf_long_mon != __long_mon) {
+	if (duf_long_mon != __long_mon && !cclp(duf_long_mon)) {
 		free(deconst(duf_long_mon));
 	}
 	duf_long_mon = __long_mon;
@@ -341,7 +391,7 @@ __strf_reset_long_mon(void)
 static inline void
 __strf_reset_abbr_mon(void)
 {
-	if (dut_abbr_mon != __abbr_mon) {
+	if (dut_abbr_mon != __abbr_mon && !cclp(duf_abbr_mon)) {
 		free(deconst(duf_abbr_mon));
 	}
 	duf_abbr_mon = __abbr_mon;
@@ -426,21 +476,24 @@ tokenise(const char *ln, size_t lz)
 {
 /* we expect \t separation */
 	struct lst_s *r;
+	char *str;
 
 	if (UNLIKELY((r = malloc(sizeof(*r) + lz)) == NULL)) {
 		return NULL;
 	}
+	/* the strings live right behind the list */
+	str = (char*)(r + 1U);
 	/* just have him point to something */
-	r->s[1U] = r->str;
+	r->s[1U] = str;
 	r->min = -1ULL;
 	r->max = 0ULL;
-	memcpy(r->str, ln, lz);
+	memcpy(str, ln, lz);
 	for (size_t i = 0U, j = 2U, o = 0U; i < lz && j < countof(r->s); i++) {
 		/* just map all ascii ctrl characters to NUL */
-		r->str[i] &= (char)(((unsigned char)r->str[i] < ' ') - 1U);
-		if (UNLIKELY(!r->str[i])) {
+		str[i] &= (char)(((unsigned char)str[i] < ' ') - 1U);
+		if (UNLIKELY(!str[i])) {
 			const size_t len = i - o;
-			r->s[j++] = r->str + (o = i + 1U);
+			r->s[j++] = str + (o = i + 1U);
 			if (len > r->max) {
 				r->max = len;
 			}
@@ -519,8 +572,130 @@ uhoh:
 	return -1;
 }
 
+
+/* compiled locale files */
+static const struct dtl_s*
+dtl_open(const char *fn, const char *tfn, size_t *fz)
+{
+/* map compiled locale file FN, its size goes into FZ,
+ * if text file TFN is newer than FN, FN is considered stale */
+	struct stat st[1U];
+	struct stat tst[1U];
+	const struct dtl_s *c;
+	int fd;
+
+	if ((fd = open(fn, O_RDONLY)) < 0) {
+		return NULL;
+	} else if (UNLIKELY(fstat(fd, st) < 0)) {
+		c = NULL;
+	} else if (tfn != NULL && stat(tfn, tst) == 0 &&
+		   tst->st_mtime > st->st_mtime) {
+		/* someone edited the text file, use that one instead */
+		c = NULL;
+	} else if ((size_t)st->st_size <= sizeof(*c)) {
+		c = NULL;
+	} else if ((c = mmap(NULL, st->st_size, PROT_READ, MAP_SHARED, fd, 0))
+		   == MAP_FAILED) {
+		c = NULL;
+	} else if (memcmp(c->magic, DTL_MAGIC, sizeof(c->magic)) ||
+		   /* we need the locales and a terminated string pool */
+		   (size_t)st->st_size <=
+		   sizeof(*c) + be32toh(c->nloc) * sizeof(*c->loc) ||
+		   ((const char*)c)[st->st_size - 1] != '\0') {
+		munmap(deconst(c), st->st_size);
+		c = NULL;
+	} else {
+		*fz = st->st_size;
+	}
+	close(fd);
+	return c;
+}
+
+static const struct dtl_loc_s*
+dtl_find(const struct dtl_s *c, size_t fz, const char *ln, size_t lz)
+{
+/* bisect C's locales for LN */
+	size_t lo = 0U;
+	size_t hi = be32toh(c->nloc);
+
+	while (lo < hi) {
+		const size_t mid = (lo + hi) / 2U;
+		const uint32_t o = be32toh(c->loc[mid].name);
+		const char *nm = (const char*)c + (o < fz ? o : fz - 1U);
+		int cmp;
+
+		if ((cmp = strncmp(nm, ln, lz)) == 0) {
+			/* a longer name sorts after LN */
+			cmp = nm[lz] != '\0';
+		}
+		if (cmp < 0) {
+			lo = mid + 1U;
+		} else if (cmp > 0) {
+			hi = mid;
+		} else {
+			return c->loc + mid;
+		}
+	}
+	return NULL;
+}
+
+static const char*
+dtl_str(const struct dtl_s *c, size_t fz, uint32_t o)
+{
+	o = be32toh(o);
+	/* offsets out of bounds point to the pool's terminating NUL */
+	return (const char*)c + (o < fz ? o : fz - 1U);
+}
+
+static const struct dtl_s*
+dtl_get(const char *fn, const char *tfn, size_t *fz)
+{
+/* map FN once and for all, the name lists in CLOC point into it */
+	static const struct dtl_s *c;
+	static size_t cz;
+	static bool triedp;
+
+	if (!triedp) {
+		c = dtl_open(fn, tfn, &cz);
+		triedp = true;
+	}
+	*fz = cz;
+	return c;
+}
+
+static int
+__setlocale_cc(
+	const struct dtl_s *c, size_t fz, const char *ln, size_t lz,
+	void(*setf)(struct loc_s), struct lst_s cl[static 4U])
+{
+	const struct dtl_loc_s *l;
+
+	if ((l = dtl_find(c, fz, ln, lz)) == NULL) {
+		/* just like the text version, unknown locales are no error */
+		return 0;
+	}
+	for (size_t i = 0U; i < countof(l->lst); i++) {
+		const struct dtl_lst_s *src = l->lst + i;
+
+		for (size_t j = 0U; j < countof(src->s); j++) {
+			cl[i].s[j] = dtl_str(c, fz, src->s[j]);
+		}
+		cl[i].min = be16toh(src->min);
+		cl[i].max = be16toh(src->max);
+	}
+	setf((struct loc_s){
+			.abbr_wday = cl + 0U,
+			.long_wday = cl + 1U,
+			.abbr_mon = cl + 2U,
+			.long_mon = cl + 3U,
+		});
+	return 0;
+}
+
 static int
-__setlocale(const char *ln, size_t lz, void(*setf)(struct loc_s))
+__setlocale(
+	const char *ln, size_t lz,
+	void(*setf)(struct loc_s), struct lst_s cl[static 4U])
 {
 	struct stat st[1U];
 	const char *fn;
@@ -528,8 +703,20 @@ __setlocale(const char *ln, size_t lz, void(*setf)(struct loc_s))
 	int fd;
 	int rc = 0;
 
-	/* we shall assume locale file is LOCALE_FILE */
-	fn = getenv("LOCALE_FILE") ?: locfn;
+	/* we shall assume locale file is LOCALE_FILE, compiled or not,
+	 * the default compiled file is only used if it's no older than
+	 * the text file it was compiled from */
+	fn = getenv("LOCALE_FILE");
+	with (const struct dtl_s *c) {
+		size_t cz;
+
+		c = dtl_get(fn ?: loccfn, fn ? NULL : locfn, &cz);
+		if (c != NULL) {
+			return __setlocale_cc(c, cz, ln, lz, setf, cl);
+		}
+	}
+	/* plain text then */
+	fn = fn ?: locfn;
 
 	if ((fd = open(fn, O_RDONLY)) < 0) {
 		/* buggery */
@@ -586,7 +773,7 @@ setilocale(const char *ln)
 		return 0;
 	}
 
-	return __setlocale(ln, lz, set_il);
+	return __setlocale(ln, lz, set_il, cloc[0U]);
 }
 
 int
@@ -599,7 +786,306 @@ setflocale(const char *ln)
 		return 0;
 	}
 
-	return __setlocale(ln, lz, set_fl);
+	return __setlocale(ln, lz, set_fl, cloc[1U]);
+}
+
+
+#if defined STANDALONE
+static __attribute__((format(printf, 1, 2))) void
+error(const char *fmt, ...)
+{
+	va_list vap;
+	va_start(vap, fmt);
+	vfprintf(stderr, fmt, vap);
+	va_end(vap);
+	fputc('\n', stderr);
+	return;
+}
+
+static __attribute__((format(printf, 1, 2))) void
+serror(const char *fmt, ...)
+{
+	va_list vap;
+	va_start(vap, fmt);
+	vfprintf(stderr, fmt, vap);
+	va_end(vap);
+	if (errno) {
+		fputc(':', stderr);
+		fputc(' ', stderr);
+		fputs(strerror(errno), stderr);
+	}
+	fputc('\n', stderr);
+	return;
+}
+
+/* locales in host byte order, offsets relative to the pool */
+static struct dtl_loc_s *locs;
+static size_t nlocs;
+static size_t zlocs;
+/* string pool, begins with the empty string */
+static char *pool;
+static size_t npool;
+static size_t zpool;
+
+static uint32_t
+pool_add(const char *s, size_t z)
+{
+	if (UNLIKELY(npool + z + 1U > zpool)) {
+		while ((zpool = (zpool * 2U) ?: 4096U) < npool + z + 1U);
+		pool = realloc(pool, zpool);
+	}
+	memcpy(pool + npool, s, z);
+	pool[npool + z] = '\0';
+	npool += z + 1U;
+	return (uint32_t)(npool - z - 1U);
+}
+
+static int
+parse_lst(struct dtl_lst_s *restrict tgt, const char *ln, size_t lz)
+{
+/* split LN at ascii ctrl characters, much like tokenise() */
+	size_t j = 1U;
+
+	memset(tgt, 0, sizeof(*tgt));
+	tgt->min = UINT16_MAX;
+	for (size_t i = 0U, o = 0U; i <= lz; i++) {
+		if (i < lz && (unsigned char)ln[i] >= ' ') {
+			continue;
+		} else if (j >= countof(tgt->s) - 1U) {
+			/* more names than months in a year */
+			return -1;
+		}
+		tgt->s[j++] = pool_add(ln + o, i - o);
+		if (i - o > tgt->max) {
+			tgt->max = (uint16_t)(i - o);
+		}
+		if (i - o < tgt->min) {
+			tgt->min = (uint16_t)(i - o);
+		}
+		o = i + 1U;
+	}
+	return 0;
+}
+
+static int
+parse_file(const char *file)
+{
+	char *line = NULL;
+	size_t llen = 0U;
+	size_t lno = 0U;
+	FILE *fp;
+	int rc = 0;
+
+	if (file == NULL) {
+		fp = stdin;
+	} else if ((fp = fopen(file, "r")) == NULL) {
+		return -1;
+	}
+
+	/* 5 lines per locale, its name followed by the name lists */
+	for (ssize_t nrd; (nrd = getline(&line, &llen, fp)) > 0; lno++) {
+		const size_t lz = nrd - (line[nrd - 1] == '\n');
+
+		if (lno % 5U == 0U) {
+			if (UNLIKELY(nlocs >= zlocs)) {
+				zlocs = (zlocs * 2U) ?: 256U;
+				locs = realloc(locs, zlocs * sizeof(*locs));
+			}
+			locs[nlocs++].name = pool_add(line, lz);
+		} else if (parse_lst(
+				   locs[nlocs - 1U].lst + (lno % 5U - 1U),
+				   line, lz) < 0) {
+			error("Error in %s:%zu: too many names",
+			      file ?: "-", lno + 1U);
+			rc = -1;
+		}
+	}
+	if (lno % 5U) {
+		error("Error in %s: incomplete last locale", file ?: "-");
+		rc = -1;
+	}
+
+	free(line);
+	fclose(fp);
+	return rc;
+}
+
+static int
+loc_cmp(const void *a, const void *b)
+{
+	const struct dtl_loc_s *x = a;
+	const struct dtl_loc_s *y = b;
+
+	return strcmp(pool + x->name, pool + y->name);
+}
+#endif	/* STANDALONE */
+
+
+#if defined STANDALONE
+#include "dtlocale.yucc"
+
+static int
+cmd_cc(const struct yuck_cmd_cc_s argi[static 1U])
+{
+	const char *outf;
+	int rc = 0;
+	int ofd;
+
+	/* offset 0 of the pool is the empty string */
+	pool_add("", 0U);
+	if (parse_file(argi->args[0U]) < 0) {
+		error("cannot read file `%s'", *argi->args ?: "stdin");
+		rc = 1;
+		goto out;
+	}
+	qsort(locs, nlocs, sizeof(*locs), loc_cmp);
+	for (size_t i = 1U; i < nlocs; i++) {
+		if (!loc_cmp(locs + i - 1U, locs + i)) {
+			error("Error: duplicate locale `%s'", pool + locs[i].name);
+			rc = 1;
+		}
+	}
+	if (rc) {
+		goto out;
+	}
+
+	if ((outf = argi->output_arg ?: "locale.dtl", false)) {
+		;
+	} else if ((ofd = open(outf, O_RDWR | O_CREAT | O_TRUNC, 0666)) < 0) {
+		serror("cannot open output file `%s'", outf);
+		rc = 1;
+		goto out;
+	}
+
+	/* generate a disk version now */
+	{
+		static struct dtl_s c = {.magic = DTL_MAGIC};
+		const uint32_t base = sizeof(c) + nlocs * sizeof(*locs);
+		ssize_t sz;
+
+		c.nloc = htobe32((uint32_t)nlocs);
+		if (sz = sizeof(c), write(ofd, &c, sz) < sz) {
+			goto trunc;
+		}
+		for (size_t i = 0U; i < nlocs; i++) {
+			struct dtl_loc_s l = locs[i];
+
+			/* big-endian file offsets on disk */
+			l.name = htobe32(base + l.name);
+			for (size_t j = 0U; j < countof(l.lst); j++) {
+				for (size_t k = 0U; k < countof(l.lst->s); k++) {
+					l.lst[j].s[k] = htobe32(base + l.lst[j].s[k]);
+				}
+				l.lst[j].min = htobe16(l.lst[j].min);
+				l.lst[j].max = htobe16(l.lst[j].max);
+			}
+			if (sz = sizeof(l), write(ofd, &l, sz) < sz) {
+				goto trunc;
+			}
+		}
+		if (sz = npool, write(ofd, pool, sz) < sz) {
+			goto trunc;
+		}
+		close(ofd);
+		goto out;
+
+	trunc:
+		/* some write failed, leave a 0 byte file around */
+		close(ofd);
+		unlink(outf);
+		rc = 1;
+	}
+
+out:
+	free(locs);
+	free(pool);
+	return rc;
+}
+
+static void
+prnt_loc(const struct dtl_s *c, size_t fz, const struct dtl_loc_s *l)
+{
+	/* weekdays and months */
+	static const size_t nnm[] = {7U, 7U, 12U, 12U};
+
+	puts(dtl_str(c, fz, l->name));
+	for (size_t i = 0U; i < countof(l->lst); i++) {
+		for (size_t j = 1U; j <= nnm[i]; j++) {
+			if (j > 1U) {
+				fputc('\t', stdout);
+			}
+			fputs(dtl_str(c, fz, l->lst[i].s[j]), stdout);
+		}
+		fputc('\n', stdout);
+	}
+	return;
+}
+
+static int
+cmd_show(const struct yuck_cmd_show_s argi[static 1U])
+{
+	const struct dtl_s *c;
+	const char *fn;
+	size_t fz;
+	int rc = 0;
+
+	if ((fn = argi->locale_file_arg ?: "locale.dtl", false)) {
+		;
+	} else if ((c = dtl_open(fn, NULL, &fz)) == NULL) {
+		serror("cannot open input file `%s'", fn);
+		return 1;
+	}
+
+	if (!argi->nargs) {
+		/* dump mode */
+		for (size_t i = 0U, n = be32toh(c->nloc); i < n; i++) {
+			prnt_loc(c, fz, c->loc + i);
+		}
+	}
+	/* otherwise */
+	for (size_t i = 0U; i < argi->nargs; i++) {
+		const char *ln = argi->args[i];
+		const struct dtl_loc_s *l;
+
+		if ((l = dtl_find(c, fz, ln, strlen(ln))) == NULL) {
+			error("Error: no such locale `%s'", ln);
+			rc = 1;
+			continue;
+		}
+		prnt_loc(c, fz, l);
+	}
+
+	munmap(deconst(c), fz);
+	return rc;
+}
+
+int
+main(int argc, char *argv[])
+{
+	yuck_t argi[1U];
+	int rc = 0;
+
+	if (yuck_parse(argi, argc, argv) < 0) {
+		rc = 1;
+		goto out;
+	}
+
+	switch (argi->cmd) {
+	case DTLOCALE_CMD_CC:
+		rc = cmd_cc((void*)argi);
+		break;
+	case DTLOCALE_CMD_SHOW:
+		rc = cmd_show((void*)argi);
+		break;
+	default:
+		rc = 1;
+		break;
+	}
+
+out:
+	yuck_free(argi);
+	return rc;
 }
+#endif	/* STANDALONE */
 
 /* locale.c ends here */
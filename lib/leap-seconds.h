@@ -32,4 +32,13 @@ extern const int32_t leaps_s[];
  * HMS representation of transitions. */
 extern const uint32_t leaps_hms[];
 
+/**
+ * Combined daisy<<24 | HMS representation of transitions, without
+ * sentinels but padded to a multiple of LEAPS_WIDTH. */
+extern const uint64_t leaps_dhms[];
+
+/**
+ * Padded size of leaps_dhms. */
+extern const size_t nleaps_dhms;
+
 #endif	/* INCLUDED_leap_seconds_h_ */
@@ -128,5 +128,25 @@ leaps_before_si64(const int64_t fld[], size_t nfld, int64_t key)
 	return find_before_si64(fld, nfld, key, this, min, max);
 }
 
+DEFUN zidx_t
+leaps_rank_ui64(const uint64_t fld[], size_t nfld, uint64_t key)
+{
+/* bisection without branches, compilers turn the ternary into cmovs
+ * and for tables this small that beats both the branchy bisection
+ * and a linear vector scan */
+	const uint64_t *b = fld;
+
+	if (UNLIKELY(!nfld)) {
+		return 0U;
+	}
+	for (size_t n = nfld; n > 1U;) {
+		const size_t h = n / 2U;
+
+		b = b[h] < key ? b + h : b;
+		n -= h;
+	}
+	return (b - fld) + (*b < key);
+}
+
 #endif	/* INCLUDED_leaps_c_ */
 /* leaps.c ends here */
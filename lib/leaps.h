@@ -48,6 +48,10 @@ typedef const struct zleap_s *zleap_t;
 typedef const int32_t *zltr_t;
 typedef size_t zidx_t;
 
+/* flat tables are padded to a multiple of this many elements,
+ * i.e. whole cache lines for 64bit keys */
+#define LEAPS_WIDTH	(8U)
+
 /* row-based */
 struct zleap_s {
 	union {
@@ -74,6 +78,11 @@ extern zidx_t leaps_before_ui64(const uint64_t fld[], size_t nfld, uint64_t key)
  * Return last leap transition before KEY in a int64_t field FLD. */
 extern zidx_t leaps_before_si64(const int64_t fld[], size_t nfld, int64_t key);
 
+/**
+ * Return the number of leap transitions before KEY in a sorted
+ * uint64_t field FLD without sentinels. */
+extern zidx_t leaps_rank_ui64(const uint64_t fld[], size_t nfld, uint64_t key);
+
 #if defined __cplusplus
 }
 #endif	/* __cplusplus */
@@ -46,6 +46,7 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
+#include <inttypes.h>
 
 #include "leaps.h"
 #include "date-core.h"
@@ -316,6 +317,69 @@ const uint32_t %s[] = {\n\
 	return 0;
 }
 
+static int
+pr_line_dhms(const char *line, size_t llen, va_list UNUSED(vap))
+{
+	static long int cor;
+	static size_t n;
+	struct dt_t_s t = {DT_TUNK};
+	struct dt_d_s d;
+	long int val;
+	char *ep;
+
+	if (llen == PROLOGUE) {
+		/* prologue */
+		fprintf(stdout, "\
+const uint64_t %s[] __attribute__((aligned(64))) = {\n", line);
+		return 0;
+	} else if (llen == EPILOGUE) {
+		/* pad to a multiple of LEAPS_WIDTH */
+		for (; n % LEAPS_WIDTH; n++) {
+			fputs("\tUINT64_MAX,\n", stdout);
+		}
+		fputs("};\n", stdout);
+		cor = 0;
+		n = 0U;
+		return 0;
+	} else if (line == NULL) {
+		return -1;
+	} else if (line[0] == '#') {
+		/* comment line */
+		return 0;
+	} else if (line[0] == '\n') {
+		/* empty line */
+		return 0;
+	}
+	/* otherwise process */
+	if ((ep = NULL, val = strtol(line, &ep, 10), ep == NULL)) {
+		return -1;
+	}
+
+	/* day part like pr_line_d() ... */
+	d = (struct dt_d_s){DT_DAISY, .daisy = val / 86400 + 109207};
+	/* ... time part like pr_line_t() */
+	val--;
+	t.hms.s = val % 60L;
+	val /= 60L;
+	t.hms.m = val % 60L;
+	val /= 60L;
+	t.hms.h = val % 24L;
+
+	/* read correction */
+	if ((val = strtol(ep, &ep, 10), ep == NULL)) {
+		return -1;
+	}
+
+	with (uint64_t ual = t.hms.u24) {
+		ual += val >= cor;
+		ual |= (uint64_t)d.daisy << 24U;
+		fprintf(stdout, "\t0x%" PRIx64 "U,\n", ual);
+		cor = val;
+	}
+	n++;
+	return 0;
+}
+
 static int
 pr_file(FILE *fp, const char *var, int(*cb)(const char*, size_t, va_list), ...)
 {
@@ -393,6 +457,11 @@ parse_file(const char *file)
 	rewind(fp);
 	pr_file(fp, "leaps_hms", pr_line_t, DT_HMS, col);
 
+	if (col) {
+		rewind(fp);
+		pr_file(fp, "leaps_dhms", pr_line_dhms);
+	}
+
 	fputs("\
 /* exported number of leap transitions */\n\
 const size_t nleaps = countof(leaps_corr);\n\
@@ -42,6 +42,7 @@
 # include "config.h"
 #endif	/* HAVE_CONFIG_H */
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 /* for strncasecmp() */
 #include <strings.h>
@@ -253,6 +254,137 @@ ui32tostrrom(char *restrict buf, size_t bsz, uint32_t d)
 	return res;
 }
 
+/* digit pairs 00 to 99, so we only need a division every other digit */
+static const char dig2[200U] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static inline size_t
+__ndig64(uint64_t d)
+{
+	static const uint64_t p10[] = {
+		1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL,
+		1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+		10000000000ULL, 100000000000ULL, 1000000000000ULL,
+		10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+		10000000000000000ULL, 100000000000000000ULL,
+		1000000000000000000ULL, 10000000000000000000ULL,
+	};
+	/* 1233/4096 is just above log10(2), so this is the number of digits
+	 * or one too many, the table tells which */
+	const unsigned int t = (64U - __builtin_clzll(d | 1U)) * 1233U >> 12U;
+
+	return t + (d >= p10[t]) + !d;
+}
+
+static inline void
+__pr_digs(char *restrict ep, uint64_t d)
+{
+/* print D backwards into the digits ending at EP */
+	for (; d >= 100U; d /= 100U) {
+		ep -= 2U;
+		memcpy(ep, dig2 + 2U * (d % 100U), 2U);
+	}
+	if (d >= 10U) {
+		memcpy(ep - 2U, dig2 + 2U * d, 2U);
+	} else {
+		ep[-1] = (char)('0' + d);
+	}
+	return;
+}
+
+DEFUN size_t
+ui64tostr(char *restrict buf, size_t bsz, uint64_t d)
+{
+	const size_t n = __ndig64(d);
+
+	if (UNLIKELY(n > bsz)) {
+		return 0U;
+	}
+	__pr_digs(buf + n, d);
+	if (n < bsz) {
+		buf[n] = '\0';
+	}
+	return n;
+}
+
+DEFUN size_t
+si64tostr(char *restrict buf, size_t bsz, int64_t d)
+{
+	if (d >= 0) {
+		return ui64tostr(buf, bsz, (uint64_t)d);
+	} else if (UNLIKELY(bsz < 2U)) {
+		return 0U;
+	}
+	with (size_t n = ui64tostr(buf + 1U, bsz - 1U, -(uint64_t)d)) {
+		if (UNLIKELY(!n)) {
+			return 0U;
+		}
+		*buf = '-';
+		return n + 1U;
+	}
+	/* not reached */
+	return 0U;
+}
+
+DEFUN size_t
+fix6tostr(char *restrict buf, size_t bsz, double x)
+{
+/* below 2^22 the scaled value is exact to 2^-10, good enough to tell
+ * whether we're close to a rounding tie, in which case (or when out of
+ * range) we leave it to the libc to round the exact binary value */
+#define FIX6_LIM	(4194304U)
+	const int neg = __builtin_signbit(x);
+	const double a = neg ? -x : x;
+	double v, r;
+	uint64_t q;
+	size_t n;
+
+	if (UNLIKELY(!(a < FIX6_LIM))) {
+		goto libc;
+	}
+	v = a * (double)1000000U;
+	q = (uint64_t)v;
+	/* fractional part in thousandths, no need to be more precise */
+	r = (v - (double)q) * (double)1000U;
+	if (UNLIKELY(r > (double)498U && r < (double)502U)) {
+		goto libc;
+	}
+	q += r > (double)500U;
+
+	n = (size_t)(neg != 0) + __ndig64(q / 1000000U) + 7U;
+	if (UNLIKELY(n > bsz)) {
+		return 0U;
+	}
+	if (neg) {
+		*buf = '-';
+	}
+	__pr_digs(buf + n - 7U, q / 1000000U);
+	__pr_digs(buf + n, q % 1000000U + 1000000U);
+	/* the extra 1000000 left a 1 where the decimal point goes */
+	buf[n - 7U] = '.';
+	if (n < bsz) {
+		buf[n] = '\0';
+	}
+	return n;
+
+libc:
+	with (int z = snprintf(buf, bsz, "%.6f", x)) {
+		return z > 0 ? (size_t)z : 0U;
+	}
+	/* not reached */
+	return 0U;
+#undef FIX6_LIM
+}
+
 
 DEFUN int
 __ordinalp(const char *num, size_t off_suf, char **ep)
@@ -66,6 +66,23 @@ romstrtoi_lim(const char *str, const char **ep, int32_t llim, int32_t ulim);
 extern size_t
 ui32tostrrom(char *restrict buf, size_t bsz, uint32_t d);
 
+/**
+ * Convert D to decimal like "%" PRIu64 and put it into BUF, return the size.
+ * If BUF is too small nothing is written and 0 is returned. */
+extern size_t
+ui64tostr(char *restrict buf, size_t bsz, uint64_t d);
+
+/**
+ * Like ui64tostr() but for signed D, like "%" PRIi64. */
+extern size_t
+si64tostr(char *restrict buf, size_t bsz, int64_t d);
+
+/**
+ * Convert X to decimal with 6 fractional digits like "%.6f", put it
+ * into BUF and return the size. */
+extern size_t
+fix6tostr(char *restrict buf, size_t bsz, double x);
+
 /**
  * Find and skip ordinal suffixes in SUF, point to the end of the suffix. */
 extern int __ordinalp(const char *num, size_t off_suf, char **ep);
@@ -133,6 +133,20 @@ struct zleap_tr_s {
 	int32_t corr;
 };
 
+/* local wall time view on transitions */
+struct zlcl_s {
+	/* local time from which on this entry applies */
+	int32_t lcl;
+	/* what to add to get to UTC, zif_utc_time()'s choice first,
+	 * then the earliest and the latest UTC instant, the latter two
+	 * differ in gaps and overlaps only */
+	int32_t dflt;
+	int32_t erly;
+	int32_t late;
+	/* 1 in gaps, -1 in overlaps, 0 otherwise */
+	int32_t kind;
+};
+
 /* leap second support missing */
 struct zif_s {
 	size_t mpsz;
@@ -155,6 +169,15 @@ struct zif_s {
 
 	/* zone caching, between PREV and NEXT the offset is OFFS */
 	struct zrng_s cache;
+	/* cache statistics */
+	size_t nhit;
+	size_t nmiss;
+
+	/* local time table, sorted, NULL if unavailable */
+	struct zlcl_s *lcl;
+	size_t nlcl;
+	/* most recently used entry */
+	size_t lcl_last;
 };
 
 
@@ -227,7 +250,7 @@ zif_nleaps(const struct zif_s z[static 1U])
 
 /**
  * Return the transition time stamp of the N-th transition in Z. */
-static inline int32_t
+DEFUN int32_t
 zif_trans(const struct zif_s z[static 1U], int n)
 {
 	size_t ntr = zif_ntrans(z);
@@ -484,19 +507,29 @@ __copy(const struct zif_s z[static 1U])
 	}
 	memcpy(res, z, z->mpsz);
 	__init_zif(res);
+	res->nhit = res->nmiss = 0U;
+	/* the local time table isn't ours */
+	res->lcl = NULL;
+	res->nlcl = res->lcl_last = 0U;
 	return res;
 }
 
+static void __init_lcl(struct zif_s z[static 1U]);
+
 DEFUN zif_t
 zif_copy(zif_t z)
 {
 /* copy Z into a newly allocated zif_t object
  * if applicable also perform byte-order conversions */
+	struct zif_s *res;
+
 	if (UNLIKELY(z == NULL)) {
 		/* no need to bother */
 		return NULL;
+	} else if (LIKELY((res = __copy(z)) != NULL)) {
+		__init_lcl(res);
 	}
-	return __copy(z);
+	return res;
 }
 
 static void
@@ -525,6 +558,7 @@ zif_close(zif_t z)
 		/* nothing to do */
 		return;
 	}
+	free(z->lcl);
 	__close((const void*)z);
 	return;
 }
@@ -551,7 +585,9 @@ zif_open(const char *file)
 	/* otherwise all's fine, it's still BE
 	 * assign the coord zone type if any and convert to host byte-order */
 	tmp->cz = cz;
-	res = __copy(tmp);
+	if (LIKELY((res = __copy(tmp)) != NULL)) {
+		__init_lcl(res);
+	}
 	__close(tmp);
 	return res;
 }
@@ -570,7 +606,8 @@ __find_trno(const struct zif_s z[static 1U], int32_t t, int min, int max)
 		return -1;
 	} else if (UNLIKELY(t < zif_trans(z, min))) {
 		return -1;
-	} else if (UNLIKELY(t > zif_trans(z, max))) {
+	} else if (UNLIKELY(t >= zif_trans(z, max - 1))) {
+		/* at or after the last one, bisecting would never end */
 		return max - 1;
 	}
 
@@ -668,9 +705,6 @@ static int32_t
 __offs(struct zif_s z[static 1U], int32_t t)
 {
 /* return the offset of T in Z and cache the result. */
-	int min;
-	size_t max;
-
 	switch (z->cz) {
 	default:
 	case TZCZ_UNK:
@@ -686,19 +720,60 @@ __offs(struct zif_s z[static 1U], int32_t t)
 	/* use the classic code */
 	if (LIKELY(t >= z->cache.prev && t < z->cache.next)) {
 		/* use the cached offset */
+		z->nhit++;
 		return z->cache.offs;
-	} else if (t >= z->cache.next) {
-		min = z->cache.trno + 1;
-		max = zif_ntrans(z);
-	} else if (t < z->cache.prev) {
-		max = z->cache.trno;
-		min = 0;
-	} else {
-		/* we shouldn't end up here at all */
-		min = 0;
-		max = 0;
 	}
-	return (z->cache = __find_zrng(z, t, min, max)).offs;
+	z->nmiss++;
+	/* the cache is all zeroes initially, so its bounds can't be used
+	 * to narrow down the search */
+	with (struct zrng_s r = __find_zrng(z, t, 0, zif_ntrans(z))) {
+		if (UNLIKELY(t < zif_trans(z, 0))) {
+			/* before the first transition the range is bogus */
+			return r.offs;
+		}
+		z->cache = r;
+	}
+	return z->cache.offs;
+}
+
+DEFUN void
+zif_cache_stats(zif_t z, size_t *restrict nhit, size_t *restrict nmiss)
+{
+	if (UNLIKELY(z == NULL)) {
+		*nhit = *nmiss = 0U;
+		return;
+	}
+	*nhit = z->nhit;
+	*nmiss = z->nmiss;
+	return;
+}
+
+static const struct zlcl_s*
+__lcl(const struct zif_s z[static 1U], int32_t t)
+{
+/* find the local time table entry T belongs to */
+	size_t k = z->lcl_last;
+
+	if (LIKELY(t >= z->lcl[k].lcl &&
+		   (k + 1U >= z->nlcl || t < z->lcl[k + 1U].lcl))) {
+		/* use the cached entry */
+		return z->lcl + k;
+	}
+	/* bisect, the first entry starts at INT_MIN */
+	with (size_t lo = 0U, hi = z->nlcl) {
+		while (hi - lo > 1U) {
+			size_t this = (lo + hi) / 2U;
+
+			if (z->lcl[this].lcl <= t) {
+				lo = this;
+			} else {
+				hi = this;
+			}
+		}
+		k = lo;
+	}
+	AS_MUT_ZIF(z)->lcl_last = k;
+	return z->lcl + k;
 }
 
 DEFUN int32_t
@@ -722,6 +797,9 @@ zif_utc_time(zif_t z, int32_t t)
 	/* jump off the cliff if Z is nought */
 	if (UNLIKELY(z == NULL)) {
 		return t;
+	} else if (LIKELY(z->lcl != NULL)) {
+		/* one lookup in the local time table */
+		return t + __lcl(z, t)->dflt;
 	}
 
 	while ((xj = __offs(AS_MUT_ZIF(z), t - xi)) != xi && xi != old) {
@@ -730,6 +808,34 @@ zif_utc_time(zif_t z, int32_t t)
 	return t - xj;
 }
 
+DEFUN int32_t
+zif_utc_time_ambig(zif_t z, int32_t t, zif_ambig_t how, int *kind)
+{
+	const struct zlcl_s *l;
+
+	if (UNLIKELY(z == NULL || z->lcl == NULL)) {
+		/* no gaps or overlaps that we know of */
+		if (kind != NULL) {
+			*kind = 0;
+		}
+		return zif_utc_time(z, t);
+	}
+	l = __lcl(z, t);
+	if (kind != NULL) {
+		*kind = l->kind;
+	}
+	switch (how) {
+	case ZIF_AMBIG_EARLIEST:
+		return t + l->erly;
+	case ZIF_AMBIG_LATEST:
+		return t + l->late;
+	default:
+	case ZIF_AMBIG_DFLT:
+		break;
+	}
+	return t + l->dflt;
+}
+
 /* convert utc to local */
 DEFUN int32_t
 zif_local_time(zif_t z, int32_t t)
@@ -741,5 +847,386 @@ zif_local_time(zif_t z, int32_t t)
 	return t + __offs(AS_MUT_ZIF(z), t);
 }
 
+
+/* zone pairs */
+struct zif_pair_s {
+	zif_t from;
+	zif_t to;
+
+	/* number of segments, 0 if conversions must go the long way */
+	size_t nseg;
+	/* local FROM time at which each segment starts, sorted */
+	int32_t *beg;
+	/* what to add to local FROM times in each segment */
+	int32_t *dlt;
+
+	/* segment caching, the most recently used one */
+	size_t last;
+};
+
+#define AS_MUT_ZPR(x)	((struct zif_pair_s*)deconst(x))
+
+static int32_t
+__offs_nxt(const struct zif_s *z, int64_t t, int64_t *nxt)
+{
+/* like __offs() but without touching the cache, also put the time
+ * of the next transition after T into NXT */
+	int lo = -1;
+	int hi;
+
+	if (z == NULL || z->cz == TZCZ_UTC) {
+		*nxt = INT64_MAX;
+		return 0;
+	} else if (t < INT_MIN) {
+		t = INT_MIN;
+	} else if (t > INT_MAX) {
+		t = INT_MAX;
+	}
+	/* find the last transition not after T, bisecting [LO, HI) */
+	for (hi = (int)zif_ntrans(z); hi - lo > 1;) {
+		int this = (lo + hi) / 2;
+
+		if (zif_trans(z, this) <= t) {
+			lo = this;
+		} else {
+			hi = this;
+		}
+	}
+	*nxt = hi < (int)zif_ntrans(z) ? zif_trans(z, hi) : INT64_MAX;
+	/* before the first transition the first offset applies */
+	return zif_troffs(z, lo > 0 ? lo : 0);
+}
+
+static int
+__pair_add(struct zif_pair_s p[static 1U], size_t *nalloc, int32_t t, int32_t d)
+{
+	if (p->nseg && p->dlt[p->nseg - 1U] == d) {
+		/* just extends the previous segment */
+		return 0;
+	} else if (p->nseg >= *nalloc) {
+		const size_t nu = *nalloc ? *nalloc * 2U : 64U;
+		int32_t *b, *x;
+
+		if ((b = realloc(p->beg, nu * sizeof(*b))) == NULL) {
+			return -1;
+		}
+		p->beg = b;
+		if ((x = realloc(p->dlt, nu * sizeof(*x))) == NULL) {
+			return -1;
+		}
+		p->dlt = x;
+		*nalloc = nu;
+	}
+	p->beg[p->nseg] = t;
+	p->dlt[p->nseg] = d;
+	p->nseg++;
+	return 0;
+}
+
+DEFUN zif_pair_t
+zif_pair(zif_t from, zif_t to)
+{
+/* sweep through all local FROM times and note down where the result
+ * of zif_local_time(TO, zif_utc_time(FROM, t)) - t changes, which is
+ * where t crosses a FROM transition, where t - x_1 (the first offset
+ * estimate in zif_utc_time()) crosses one, or where the resulting UTC
+ * time crosses a TO transition, so gaps and overlaps are resolved
+ * just like zif_utc_time() would */
+	struct zif_pair_s *res;
+	size_t nalloc = 0U;
+
+	if (UNLIKELY((res = calloc(1U, sizeof(*res))) == NULL)) {
+		return NULL;
+	}
+	res->from = from;
+	res->to = to;
+	if ((from != NULL && from->cz != TZCZ_UNK && from->cz != TZCZ_UTC) ||
+	    (to != NULL && to->cz != TZCZ_UNK && to->cz != TZCZ_UTC)) {
+		/* leap second zones, they can go the long way */
+		return res;
+	}
+	for (int64_t t = INT_MIN, n1, n2, n3; t <= INT_MAX;) {
+		const int32_t x1 = __offs_nxt(from, t, &n1);
+		const int32_t x2 = __offs_nxt(from, t - x1, &n2);
+		const int32_t x3 = __offs_nxt(to, t - x2, &n3);
+
+		if (UNLIKELY(__pair_add(res, &nalloc, (int32_t)t, x3 - x2) < 0)) {
+			free(res->beg);
+			free(res->dlt);
+			res->beg = res->dlt = NULL;
+			res->nseg = 0U;
+			break;
+		}
+		/* transform the transitions back to local FROM time */
+		n2 = n2 < INT64_MAX ? n2 + x1 : n2;
+		n3 = n3 < INT64_MAX ? n3 + x2 : n3;
+		t = n1 < n2 ? n1 : n2;
+		t = t < n3 ? t : n3;
+	}
+	return res;
+}
+
+DEFUN void
+zif_pair_close(zif_pair_t p)
+{
+	if (UNLIKELY(p == NULL)) {
+		return;
+	}
+	free(p->beg);
+	free(p->dlt);
+	free(AS_MUT_ZPR(p));
+	return;
+}
+
+static inline size_t
+__pair_seg(zif_pair_t p, int32_t t)
+{
+/* return the index of P's segment containing T, P must have segments */
+	size_t k = p->last;
+
+	if (LIKELY(t >= p->beg[k] && (k + 1U >= p->nseg || t < p->beg[k + 1U]))) {
+		/* use the cached segment */
+		return k;
+	}
+	/* bisect, the first segment starts at INT_MIN */
+	with (size_t lo = 0U, hi = p->nseg) {
+		while (hi - lo > 1U) {
+			size_t this = (lo + hi) / 2U;
+
+			if (p->beg[this] <= t) {
+				lo = this;
+			} else {
+				hi = this;
+			}
+		}
+		k = lo;
+	}
+	AS_MUT_ZPR(p)->last = k;
+	return k;
+}
+
+static inline int32_t
+__clamp32(int64_t t)
+{
+	return t < INT_MIN ? INT_MIN : t > INT_MAX ? INT_MAX : (int32_t)t;
+}
+
+DEFUN int32_t
+zif_pair_conv(zif_pair_t p, int32_t t)
+{
+	if (UNLIKELY(p == NULL)) {
+		return t;
+	} else if (UNLIKELY(!p->nseg)) {
+		return zif_local_time(p->to, zif_utc_time(p->from, t));
+	}
+	return t + p->dlt[__pair_seg(p, t)];
+}
+
+DEFUN void
+zif_pair_conv_n(zif_pair_t p, const int64_t *in, int64_t *out, size_t n)
+{
+/* blocks whose minimum and maximum fall into the same segment (the
+ * common case for time series, sorted or not) get one offset added
+ * in a plain loop, everything else goes through the segment cache */
+#define BLKSZ	(256U)
+	if (UNLIKELY(p == NULL)) {
+		if (out != in) {
+			memmove(out, in, n * sizeof(*out));
+		}
+		return;
+	} else if (UNLIKELY(!p->nseg)) {
+		for (size_t i = 0U; i < n; i++) {
+			const int32_t t = __clamp32(in[i]);
+
+			out[i] = in[i] + (zif_pair_conv(p, t) - t);
+		}
+		return;
+	}
+	for (size_t i = 0U; i < n; i += BLKSZ) {
+		const size_t m = n - i < BLKSZ ? n - i : BLKSZ;
+		const int64_t *x = in + i;
+		int64_t lo = x[0U], hi = x[0U];
+		size_t k;
+
+		for (size_t j = 1U; j < m; j++) {
+			lo = x[j] < lo ? x[j] : lo;
+			hi = x[j] > hi ? x[j] : hi;
+		}
+		k = __pair_seg(p, __clamp32(lo));
+		if (k + 1U >= p->nseg || hi < p->beg[k + 1U]) {
+			const int64_t d = p->dlt[k];
+
+			for (size_t j = 0U; j < m; j++) {
+				out[i + j] = x[j] + d;
+			}
+			continue;
+		}
+		/* block straddles a transition */
+		for (size_t j = 0U; j < m; j++) {
+			const int64_t t = x[j];
+
+			out[i + j] = t + p->dlt[__pair_seg(p, __clamp32(t))];
+		}
+	}
+#undef BLKSZ
+	return;
+}
+
+DEFUN int
+zif_convert_n(zif_t from, zif_t to, const int64_t *in, int64_t *out, size_t n)
+{
+	zif_pair_t p;
+
+	if (UNLIKELY((p = zif_pair(from, to)) == NULL)) {
+		return -1;
+	}
+	zif_pair_conv_n(p, in, out, n);
+	zif_pair_close(p);
+	return 0;
+}
+
+
+/* local time tables */
+static int
+__lcl_add(
+	struct zlcl_s **tbl, size_t *n, size_t *nalloc,
+	int64_t t, int32_t erly, int32_t late, int32_t kind)
+{
+/* add an entry for local times from T on, with UTC offsets ERLY and LATE
+ * for the earliest and latest UTC instant, 0 the default choice for now */
+	if (t > INT_MAX) {
+		/* out of range, ignore */
+		return 0;
+	} else if (t < INT_MIN) {
+		t = INT_MIN;
+	}
+	if (*n && (*tbl)[*n - 1U].lcl == t) {
+		/* previous entry is empty, overwrite it */
+		--*n;
+	} else if (*n && (*tbl)[*n - 1U].lcl > t) {
+		/* transitions too close together to be sorted this way */
+		return -1;
+	} else if (*n >= *nalloc) {
+		const size_t nu = *nalloc ? *nalloc * 2U : 64U;
+		struct zlcl_s *x;
+
+		if ((x = realloc(*tbl, nu * sizeof(*x))) == NULL) {
+			return -1;
+		}
+		*tbl = x;
+		*nalloc = nu;
+	}
+	(*tbl)[(*n)++] = (struct zlcl_s){
+		(int32_t)t, 0, -erly, -late, kind,
+	};
+	return 0;
+}
+
+static struct zlcl_s*
+__lcl_wnd(const struct zif_s z[static 1U], size_t *nres)
+{
+/* period J is [u_j, u_j+1) in UTC with offset o_j, in local time that's
+ * [u_j + o_j, u_j+1 + o_j), local times between two of those are in a
+ * gap, local times in both are in an overlap */
+	const int ntr = (int)zif_ntrans(z);
+	struct zlcl_s *res = NULL;
+	size_t n = 0U;
+	size_t nalloc = 0U;
+	/* start of the current period's unique local times */
+	int64_t cur = INT64_MIN;
+	int32_t oj = zif_troffs(z, 0);
+
+	for (int k = 0; k <= ntr; k++) {
+		/* the next period, with a different offset */
+		int64_t u = INT64_MAX;
+		int32_t ok = oj;
+
+		for (; k < ntr && (ok = zif_troffs(z, k)) == oj; k++);
+		if (k < ntr) {
+			u = zif_trans(z, k);
+		}
+		if (UNLIKELY(__lcl_add(&res, &n, &nalloc, cur, oj, oj, 0) < 0)) {
+			goto nope;
+		} else if (u == INT64_MAX) {
+			break;
+		} else if (ok > oj) {
+			/* gap from u + oj to u + ok */
+			if (UNLIKELY(__lcl_add(
+					     &res, &n, &nalloc,
+					     u + oj, ok, oj, 1) < 0)) {
+				goto nope;
+			}
+			cur = u + ok;
+		} else {
+			/* overlap from u + ok to u + oj */
+			if (UNLIKELY(__lcl_add(
+					     &res, &n, &nalloc,
+					     u + ok, oj, ok, -1) < 0)) {
+				goto nope;
+			}
+			cur = u + oj;
+		}
+		oj = ok;
+	}
+	*nres = n;
+	return res;
+nope:
+	free(res);
+	return NULL;
+}
+
+static void
+__init_lcl(struct zif_s z[static 1U])
+{
+/* merge the entries from __lcl_wnd() with zif_utc_time()'s own choices,
+ * which we get from a pair table with UTC as target */
+	struct zif_pair_s *p;
+	struct zlcl_s *w, *res;
+	size_t nw = 0U, n = 0U, nalloc = 0U;
+
+	z->lcl = NULL;
+	z->nlcl = z->lcl_last = 0U;
+	if (z->cz != TZCZ_UNK) {
+		/* offsets come from elsewhere */
+		return;
+	} else if ((w = __lcl_wnd(z, &nw)) == NULL) {
+		return;
+	} else if ((p = AS_MUT_ZPR(zif_pair(z, NULL))) == NULL) {
+		free(w);
+		return;
+	} else if (!p->nseg) {
+		goto out;
+	}
+
+	res = NULL;
+	for (size_t i = 0U, j = 0U;;) {
+		const int64_t ni = i + 1U < p->nseg ? p->beg[i + 1U] : INT64_MAX;
+		const int64_t nj = j + 1U < nw ? w[j + 1U].lcl : INT64_MAX;
+		const int64_t t = n ? (ni < nj ? ni : nj) : INT64_MIN;
+
+		if (n && t == INT64_MAX) {
+			/* both exhausted */
+			break;
+		} else if (n) {
+			/* advance whoever starts at T */
+			i += ni == t;
+			j += nj == t;
+		}
+		if (UNLIKELY(__lcl_add(
+				     &res, &n, &nalloc, t,
+				     -w[j].erly, -w[j].late, w[j].kind) < 0)) {
+			free(res);
+			goto out;
+		}
+		res[n - 1U].dflt = p->dlt[i];
+	}
+	z->lcl = res;
+	z->nlcl = n;
+out:
+	zif_pair_close(p);
+	free(w);
+	return;
+}
+
 #endif	/* INCLUDED_tzraw_c_ */
 /* tzraw.c ends here */
@@ -104,6 +104,19 @@ struct tzhead {
 /* now our view on things */
 typedef const struct zif_s *zif_t;
 
+/* conversions from one zone to another */
+typedef const struct zif_pair_s *zif_pair_t;
+
+/* how to resolve local times in gaps and overlaps */
+typedef enum {
+	/* whatever zif_utc_time() does */
+	ZIF_AMBIG_DFLT,
+	/* pick the earliest UTC instant */
+	ZIF_AMBIG_EARLIEST,
+	/* pick the latest UTC instant */
+	ZIF_AMBIG_LATEST,
+} zif_ambig_t;
+
 typedef enum {
 	TZCZ_UNK,
 	TZCZ_UTC,
@@ -146,16 +159,59 @@ extern struct zrng_s zif_find_zrng(zif_t z, int32_t t);
  * Given T in local time specified by Z, return a T in UTC. */
 extern int32_t zif_utc_time(zif_t z, int32_t t);
 
+/**
+ * Like zif_utc_time() but resolve T as per HOW if it falls into a gap or
+ * an overlap.  In a gap the earliest instant is T minus the offset after
+ * the transition, the latest is T minus the offset before it.
+ * If KIND is non-NULL set it to 1 for T in a gap, -1 for T in an
+ * overlap and 0 for unique local times. */
+extern int32_t
+zif_utc_time_ambig(zif_t z, int32_t t, zif_ambig_t how, int *kind);
+
 /**
  * Given T in UTC, return a T in local time specified by Z. */
 extern int32_t zif_local_time(zif_t z, int32_t t);
 
+/**
+ * Merge the transitions of zones FROM and TO into one table.
+ * Either zone may be NULL for UTC.  The zones must outlive the pair. */
+extern zif_pair_t zif_pair(zif_t from, zif_t to);
+
+/**
+ * Free the resources of zone pair P, the zones themselves stay open. */
+extern void zif_pair_close(zif_pair_t p);
+
+/**
+ * Given T in local time of P's FROM zone, return T in local time of
+ * P's TO zone, like zif_local_time(to, zif_utc_time(from, T)). */
+extern int32_t zif_pair_conv(zif_pair_t p, int32_t t);
+
+/**
+ * Convert N times IN from P's FROM zone to its TO zone, storing them in
+ * OUT, which may be IN.  Times outside the int32 range are shifted by
+ * the offset in effect at the range boundary. */
+extern void
+zif_pair_conv_n(zif_pair_t p, const int64_t *in, int64_t *out, size_t n);
+
+/**
+ * Like zif_pair_conv_n() for a one-off pair of zones FROM and TO.
+ * Return 0 on success, -1 if the zones could not be merged. */
+extern int
+zif_convert_n(zif_t from, zif_t to, const int64_t *in, int64_t *out, size_t n);
+
 
 /* exposure for specific zif-inspecting tools (dzone(1) for one) */
 extern size_t zif_ntrans(zif_t z);
 
+extern int32_t zif_trans(zif_t z, int n);
+
 extern struct ztrdtl_s zif_trdtl(zif_t z, int n);
 
+/**
+ * Return how often offset lookups in Z were served from its cache. */
+extern void
+zif_cache_stats(zif_t z, size_t *restrict nhit, size_t *restrict nmiss);
+
 #if defined __cplusplus
 }
 #endif	/* __cplusplus */
@@ -76,6 +76,9 @@ dadd_add(struct dt_dt_s d, struct dt_dtdur_s dur[], size_t ndur)
 struct mass_add_clo_s {
 	void *pctx;
 	const struct grep_atom_soa_s *gra;
+	const struct dt_io_cols_s *cols;
+	char *const *fmt;
+	size_t nfmt;
 	struct __strpdtdur_st_s st;
 	struct dt_dt_s rd;
 	zif_t fromz;
@@ -136,6 +139,55 @@ proc_line(const struct mass_add_clo_s *clo, char *line, size_t llen)
 	return rc;
 }
 
+static int
+proc_cols(const struct mass_add_clo_s *clo, int lno)
+{
+	const struct dt_io_cols_s *cols = clo->cols;
+	int rc = 0;
+
+	for (unsigned int i = 0U; i < cols->ncols; i++) {
+		char *fld;
+		size_t flen = prchunk_getcolno(clo->pctx, &fld, lno, i);
+		struct dt_dt_s d;
+		char *ep = NULL;
+
+		if (UNLIKELY(fld == NULL)) {
+			/* line's got fewer columns */
+			break;
+		} else if (i) {
+			__io_putc(cols->dlm, stdout);
+		}
+		if (!dt_io_col_p(cols, i)) {
+			/* not interested */
+			;
+		} else if (!dt_unk_p(d = dt_io_strpdt_ep(
+					     fld, clo->fmt, clo->nfmt,
+					     &ep, clo->fromz))) {
+			if (UNLIKELY(d.fix) && !clo->quietp) {
+				rc = 2;
+			}
+			/* perform addition now */
+			d = dadd_add(d, clo->st.durs, clo->st.ndurs);
+
+			if (clo->hackz == NULL && clo->fromz != NULL) {
+				/* fixup zone */
+				d = dtz_forgetz(d, clo->fromz);
+			}
+			dt_io_write(d, clo->ofmt, clo->z, '\0');
+			/* copy the rest of the field */
+			flen -= ep - fld;
+			fld = ep;
+		} else if (!clo->quietp) {
+			/* unmatched, warn about it like in line mode */
+			dt_io_warn_strpdt(fld);
+			rc = 2;
+		}
+		__io_write(fld, flen, stdout);
+	}
+	__io_putc('\n', stdout);
+	return rc;
+}
+
 static int
 mass_add_dur(const struct mass_add_clo_s *clo)
 {
@@ -154,6 +206,25 @@ mass_add_dur(const struct mass_add_clo_s *clo)
 	return rc;
 }
 
+static int
+mass_add_cols(const struct mass_add_clo_s *clo)
+{
+/* like mass_add_dur() but only look at the columns in CLO->cols */
+	int rc = 0;
+
+	if (UNLIKELY(prchunk_rechunk(
+			     clo->pctx, clo->cols->dlm, clo->cols->ncols) < 0)) {
+		return -1;
+	}
+	for (int i = 0; prchunk_haslinep(clo->pctx); i++) {
+		char *line;
+
+		(void)prchunk_getline(clo->pctx, &line);
+		rc |= proc_cols(clo, i);
+	}
+	return rc;
+}
+
 static int
 mass_add_d(const struct mass_add_clo_s *clo)
 {
@@ -248,6 +319,15 @@ main(int argc, char *argv[])
 			dt_io_unescape(fmt[i]);
 		}
 	}
+	if (argi->stats_arg) {
+		const char *how = argi->stats_arg != YUCK_OPTARG_NONE
+			? argi->stats_arg : NULL;
+
+		if (dt_io_stats_init(how, fmt, nfmt, 1U) < 0) {
+			rc = 1;
+			goto out;
+		}
+	}
 
 	if (argi->from_locale_arg) {
 		setilocale(argi->from_locale_arg);
@@ -267,6 +347,10 @@ main(int argc, char *argv[])
 		struct dt_dt_s base = dt_strpdt(argi->base_arg, NULL, NULL);
 		dt_set_base(base);
 	}
+	if (argi->calendar_arg && dt_io_bizcal(argi->calendar_arg) < 0) {
+		rc = 1;
+		goto clear;
+	}
 
 	/* sanity checks, decide whether we're a mass date adder
 	 * or a mass duration adder, or both, a date and durations are
@@ -366,6 +450,53 @@ Error: cannot interpret date/time string `%s'", inp);
 				__io_write("\n", 1U, stdout);
 			}
 		}
+	} else if (st.ndurs && argi->key_arg) {
+		/* read dates from stdin, fields only */
+		struct dt_io_cols_s cols;
+		struct mass_add_clo_s clo[1];
+		void *pctx;
+
+		if (argi->backslash_escapes_flag) {
+			dt_io_unescape(argi->delimiter_arg);
+		}
+		if (dt_io_cols(&cols, argi->delimiter_arg, argi->key_arg) < 0) {
+			rc = 1;
+			goto clear;
+		}
+
+		/* no threads reading this stream */
+		__io_setlocking_bycaller(stdout);
+
+		/* using the prchunk reader now */
+		if ((pctx = init_prchunk(STDIN_FILENO)) == NULL) {
+			serror("could not open stdin");
+			goto clear;
+		}
+
+		/* build the clo and then loop */
+		clo->pctx = pctx;
+		clo->cols = &cols;
+		clo->fmt = fmt;
+		clo->nfmt = nfmt;
+		clo->st = st;
+		clo->fromz = fromz;
+		clo->hackz = hackz;
+		clo->z = z;
+		clo->ofmt = ofmt;
+		clo->quietp = argi->quiet_flag;
+		while (prchunk_fill(pctx) >= 0) {
+			const int crc = mass_add_cols(clo);
+
+			if (UNLIKELY(crc < 0)) {
+				error("Error: cannot split input into fields");
+				rc = 1;
+				break;
+			}
+			rc |= crc;
+		}
+		/* get rid of resources */
+		free_prchunk(pctx);
+
 	} else if (st.ndurs) {
 		/* read dates from stdin */
 		struct grep_atom_s __nstk[16], *needle = __nstk;
@@ -446,6 +577,7 @@ clear:
 	__strpdtdur_free(&st);
 
 	dt_io_clear_zones();
+	dt_io_clear_bizcal();
 	if (argi->from_locale_arg) {
 		setilocale(NULL);
 	}
@@ -454,6 +586,7 @@ clear:
 	}
 
 out:
+	dt_io_stats_fini();
 	yuck_free(argi);
 	return rc;
 }
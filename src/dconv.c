@@ -40,6 +40,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <unistd.h>
 #include <sys/time.h>
 #include <time.h>
 
@@ -53,13 +54,32 @@ const char *prog = "dconv";
 
 struct prln_ctx_s {
 	struct grep_atom_soa_s *ndl;
+	const struct dt_io_cols_s *cols;
+	char *const *fmt;
+	size_t nfmt;
 	const char *ofmt;
 	zif_t fromz;
 	zif_t outz;
+	/* both of the above in one, for binary to binary */
+	zif_pair_t zpair;
+	dt_io_bin_t obin;
 	int sed_mode_p;
+	int empty_mode_p;
 	int quietp;
 };
 
+static void
+write_bin(struct dt_dt_s d, dt_io_bin_t typ, zif_t zone)
+{
+	char rec[sizeof(int64_t)];
+	struct dt_io_ts_s ts = dt_io_dt2ts(d);
+
+	ts = dt_io_ts_zshift(ts, zone, false);
+	dt_io_bin_put(rec, typ, ts);
+	__io_write(rec, dt_io_bin_width(typ), stdout);
+	return;
+}
+
 static int
 proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
 {
@@ -82,6 +102,10 @@ proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
 			if (UNLIKELY(d.fix) && !ctx.quietp) {
 				rc = 2;
 			}
+			if (ctx.obin) {
+				write_bin(d, ctx.obin, ctx.outz);
+				break;
+			}
 			dt_io_write(d, ctx.ofmt, ctx.outz, '\n');
 			break;
 		} else if (ctx.sed_mode_p) {
@@ -100,6 +124,175 @@ proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
 	return rc;
 }
 
+static int
+proc_cols(struct prln_ctx_s ctx, void *pctx, int lno)
+{
+	const struct dt_io_cols_s *cols = ctx.cols;
+	int rc = 0;
+
+	for (unsigned int i = 0U; i < cols->ncols; i++) {
+		char *fld;
+		size_t flen = prchunk_getcolno(pctx, &fld, lno, i);
+		struct dt_dt_s d;
+		char *ep = NULL;
+
+		if (UNLIKELY(fld == NULL)) {
+			/* line's got fewer columns */
+			break;
+		} else if (i) {
+			__io_putc(cols->dlm, stdout);
+		}
+		if (!dt_io_col_p(cols, i)) {
+			/* not interested */
+			;
+		} else if (!dt_unk_p(d = dt_io_strpdt_ep(
+					     fld, ctx.fmt, ctx.nfmt,
+					     &ep, ctx.fromz))) {
+			if (UNLIKELY(d.fix) && !ctx.quietp) {
+				rc = 2;
+			}
+			dt_io_write(d, ctx.ofmt, ctx.outz, '\0');
+			/* copy the rest of the field */
+			flen -= ep - fld;
+			fld = ep;
+		} else if (!ctx.quietp) {
+			/* unmatched, warn about it like in line mode */
+			dt_io_warn_strpdt(fld);
+			rc = 2;
+		}
+		__io_write(fld, flen, stdout);
+	}
+	__io_putc('\n', stdout);
+	return rc;
+}
+
+static int
+proc_empty(struct prln_ctx_s ctx, char *line, size_t llen)
+{
+	struct dt_dt_s d;
+	char *ep = NULL;
+
+	if (UNLIKELY(!llen)) {
+		goto empty;
+	}
+	/* try and parse the line */
+	d = dt_io_strpdt_ep(line, ctx.fmt, ctx.nfmt, &ep, ctx.fromz);
+	if (UNLIKELY(dt_unk_p(d))) {
+		goto empty;
+	} else if (ep && (unsigned)*ep >= ' ') {
+		goto empty;
+	}
+	dt_io_write(d, ctx.ofmt, ctx.outz, '\n');
+	return 0;
+empty:
+	__io_write("\n", 1U, stdout);
+	return 0;
+}
+
+static int
+proc_file(struct prln_ctx_s ctx, const char *fn)
+{
+	void *pctx;
+	pid_t dec;
+	int fd;
+	int rc = 0;
+
+	if ((fd = dt_io_open(fn, &dec)) < 0) {
+		return -1;
+	}
+
+	/* using the prchunk reader now */
+	if ((pctx = init_prchunk(fd)) == NULL) {
+		serror("Error: cannot read from `%s'", fn ?: "<stdin>");
+		dt_io_close(fd, dec);
+		return -1;
+	}
+	while (prchunk_fill(pctx) >= 0) {
+		if (ctx.cols && UNLIKELY(prchunk_rechunk(
+				 pctx, ctx.cols->dlm, ctx.cols->ncols) < 0)) {
+			error("Error: cannot split input into fields");
+			rc = -1;
+			break;
+		}
+		for (int i = 0; prchunk_haslinep(pctx); i++) {
+			char *line;
+			size_t llen = prchunk_getline(pctx, &line);
+
+			if (ctx.cols) {
+				rc |= proc_cols(ctx, pctx, i);
+			} else if (ctx.empty_mode_p) {
+				rc |= proc_empty(ctx, line, llen);
+			} else {
+				rc |= proc_line(ctx, line, llen);
+			}
+		}
+	}
+	/* get rid of resources */
+	free_prchunk(pctx);
+	if (dt_io_close(fd, dec) < 0) {
+		return -1;
+	}
+	return rc;
+}
+
+static int
+proc_bin(struct prln_ctx_s ctx, dt_io_bin_t ibin, const char *fn)
+{
+/* read fixed-width records of type IBIN from FN and write them
+ * as records of type CTX.obin or as text if that's unset */
+#define BIN_CHUNK_SIZE	(65536U)
+	static char ibuf[BIN_CHUNK_SIZE];
+	static char obuf[BIN_CHUNK_SIZE * 2U];
+	const size_t iw = dt_io_bin_width(ibin);
+	const size_t ow = ctx.obin ? dt_io_bin_width(ctx.obin) : 0U;
+	size_t nb = 0U;
+	ssize_t nrd;
+	pid_t dec;
+	int fd;
+
+	if ((fd = dt_io_open(fn, &dec)) < 0) {
+		return -1;
+	}
+	while ((nrd = read(fd, ibuf + nb, sizeof(ibuf) - nb)) > 0) {
+		const char *rp = ibuf;
+		char *op = obuf;
+
+		for (nb += nrd; nb >= iw; rp += iw, nb -= iw) {
+			struct dt_io_ts_s ts = dt_io_bin_get(ibin, rp);
+
+			if (!ctx.obin) {
+				/* text formatter it is */
+				struct dt_dt_s d;
+
+				ts = dt_io_ts_zshift(ts, ctx.fromz, true);
+				d = dt_io_ts2dt(ts);
+				dt_io_write(d, ctx.ofmt, ctx.outz, '\n');
+				continue;
+			}
+			/* otherwise stay in the binary domain */
+			if (ctx.zpair != NULL) {
+				ts = dt_io_ts_zconv(ts, ctx.zpair);
+			} else {
+				ts = dt_io_ts_zshift(ts, ctx.fromz, true);
+				ts = dt_io_ts_zshift(ts, ctx.outz, false);
+			}
+			dt_io_bin_put(op, ctx.obin, ts);
+			op += ow;
+		}
+		__io_write(obuf, op - obuf, stdout);
+		/* move partial records to the front */
+		memmove(ibuf, rp, nb);
+	}
+	if (dt_io_close(fd, dec) < 0) {
+		return -1;
+	} else if (UNLIKELY(nb)) {
+		error("Error: trailing partial record of %zu bytes", nb);
+		return 2;
+	}
+	return 0;
+#undef BIN_CHUNK_SIZE
+}
+
 
 #include "dconv.yucc"
 
@@ -113,11 +306,41 @@ main(int argc, char *argv[])
 	int rc = 0;
 	zif_t fromz = NULL;
 	zif_t z = NULL;
+	zif_pair_t zpair = NULL;
+	dt_io_bin_t ibin = DT_IO_BIN_UNK;
+	dt_io_bin_t obin = DT_IO_BIN_UNK;
 
 	if (yuck_parse(argi, argc, argv)) {
 		rc = 1;
 		goto out;
 	}
+	if (argi->input_binary_arg &&
+	    !(ibin = dt_io_bin(argi->input_binary_arg))) {
+		error("Error: unknown record type `%s'",
+		      argi->input_binary_arg);
+		rc = 1;
+		goto out;
+	}
+	if (argi->output_binary_arg &&
+	    !(obin = dt_io_bin(argi->output_binary_arg))) {
+		error("Error: unknown record type `%s'",
+		      argi->output_binary_arg);
+		rc = 1;
+		goto out;
+	}
+	if (argi->nargs && argi->file_nargs) {
+		error("Error: DATE/TIME arguments cannot be used with --file");
+		rc = 1;
+		goto out;
+	}
+	if ((ibin || obin) &&
+	    (argi->nargs || argi->sed_mode_flag ||
+	     argi->empty_mode_flag || argi->key_arg)) {
+		error("Error: \
+binary records cannot be used with DATE/TIME arguments, -S, -E, or -k");
+		rc = 1;
+		goto out;
+	}
 	/* init and unescape sequences, maybe */
 	ofmt = argi->format_arg;
 	fmt = argi->input_format_args;
@@ -128,6 +351,15 @@ main(int argc, char *argv[])
 			dt_io_unescape(fmt[i]);
 		}
 	}
+	if (argi->stats_arg) {
+		const char *how = argi->stats_arg != YUCK_OPTARG_NONE
+			? argi->stats_arg : NULL;
+
+		if (dt_io_stats_init(how, fmt, nfmt, 1U) < 0) {
+			rc = 1;
+			goto out;
+		}
+	}
 
 	if (argi->locale_arg) {
 		setflocale(argi->locale_arg);
@@ -143,6 +375,10 @@ main(int argc, char *argv[])
 	if (argi->zone_arg) {
 		z = dt_io_zone(argi->zone_arg);
 	}
+	if (ibin && obin && (fromz != NULL || z != NULL)) {
+		/* merge both zones' transitions, saves a lookup per record */
+		zpair = zif_pair(fromz, z);
+	}
 	if (argi->base_arg) {
 		struct dt_dt_s base = dt_strpdt(argi->base_arg, NULL, NULL);
 		dt_set_base(base);
@@ -163,59 +399,38 @@ main(int argc, char *argv[])
 				dt_io_warn_strpdt(inp);
 			}
 		}
-	} else if (argi->empty_mode_flag) {
-		/* read from stdin */
-		size_t lno = 0;
-		void *pctx;
-
-		/* no threads reading this stream */
-		__io_setlocking_bycaller(stdout);
-
-		/* using the prchunk reader now */
-		if ((pctx = init_prchunk(STDIN_FILENO)) == NULL) {
-			serror("Error: could not open stdin");
-			goto clear;
-		}
-		while (prchunk_fill(pctx) >= 0) {
-			for (char *line; prchunk_haslinep(pctx); lno++) {
-				size_t llen = prchunk_getline(pctx, &line);
-				struct dt_dt_s d;
-				char *ep = NULL;
-
-				if (UNLIKELY(!llen)) {
-					goto empty;
-				}
-				/* try and parse the line */
-				d = dt_io_strpdt_ep(line, fmt, nfmt, &ep, fromz);
-				if (UNLIKELY(dt_unk_p(d))) {
-					goto empty;
-				} else if (ep && (unsigned)*ep >= ' ') {
-					goto empty;
-				}
-				dt_io_write(d, ofmt, z, '\n');
-				continue;
-			empty:
-				__io_write("\n", 1U, stdout);
-			}
-		}
-		/* get rid of resources */
-		free_prchunk(pctx);
 	} else {
-		/* read from stdin */
-		size_t lno = 0;
+		/* read from FILEs or stdin */
 		struct grep_atom_s __nstk[16], *needle = __nstk;
 		size_t nneedle = countof(__nstk);
 		struct grep_atom_soa_s ndlsoa;
-		void *pctx;
+		struct dt_io_cols_s cols;
 		struct prln_ctx_s prln = {
 			.ndl = &ndlsoa,
+			.fmt = fmt,
+			.nfmt = nfmt,
 			.ofmt = ofmt,
 			.fromz = fromz,
 			.outz = z,
+			.zpair = zpair,
+			.obin = obin,
 			.sed_mode_p = argi->sed_mode_flag,
+			.empty_mode_p = argi->empty_mode_flag,
 			.quietp = argi->quiet_flag,
 		};
 
+		if (argi->key_arg && argi->backslash_escapes_flag) {
+			dt_io_unescape(argi->delimiter_arg);
+		}
+		if (argi->key_arg &&
+		    dt_io_cols(&cols, argi->delimiter_arg, argi->key_arg) < 0) {
+			rc = 1;
+			goto clear;
+		} else if (argi->key_arg) {
+			/* fields only */
+			prln.cols = &cols;
+		}
+
 		/* no threads reading this stream */
 		__io_setlocking_bycaller(stdout);
 
@@ -228,27 +443,26 @@ main(int argc, char *argv[])
 		/* and now build the needles */
 		ndlsoa = build_needle(needle, nneedle, fmt, nfmt);
 
-		/* using the prchunk reader now */
-		if ((pctx = init_prchunk(STDIN_FILENO)) == NULL) {
-			serror("Error: could not open stdin");
-			goto ndl_free;
-		}
-		while (prchunk_fill(pctx) >= 0) {
-			for (char *line; prchunk_haslinep(pctx); lno++) {
-				size_t llen = prchunk_getline(pctx, &line);
+		for (size_t i = 0U; i < argi->file_nargs || i == 0U; i++) {
+			const char *fn = argi->file_nargs ? argi->file_args[i] : NULL;
+			int frc = ibin
+				? proc_bin(prln, ibin, fn)
+				: proc_file(prln, fn);
 
-				rc |= proc_line(prln, line, llen);
+			if (frc < 0) {
+				rc = 1;
+			} else if (rc != 1) {
+				rc |= frc;
 			}
 		}
-		/* get rid of resources */
-		free_prchunk(pctx);
-	ndl_free:
+
 		if (needle != __nstk) {
 			free(needle);
 		}
 	}
 
 clear:
+	zif_pair_close(zpair);
 	dt_io_clear_zones();
 	if (argi->from_locale_arg) {
 		setilocale(NULL);
@@ -258,6 +472,7 @@ clear:
 	}
 
 out:
+	dt_io_stats_fini();
 	yuck_free(argi);
 	return rc;
 }
@@ -707,10 +707,23 @@ main(int argc, char *argv[])
 		struct dt_dt_s base = dt_strpdt(argi->base_arg, NULL, NULL);
 		dt_set_base(base);
 	}
+	if (argi->calendar_arg && dt_io_bizcal(argi->calendar_arg) < 0) {
+		rc = 1;
+		goto out;
+	}
 
 	ofmt = argi->format_arg;
 	fmt = argi->input_format_args;
 	nfmt = argi->input_format_nargs;
+	if (argi->stats_arg) {
+		const char *how = argi->stats_arg != YUCK_OPTARG_NONE
+			? argi->stats_arg : NULL;
+
+		if (dt_io_stats_init(how, fmt, nfmt, 1U) < 0) {
+			rc = 1;
+			goto out;
+		}
+	}
 
 	if (argi->nargs == 0 ||
 	    (refinp = argi->args[0U],
@@ -817,11 +830,13 @@ main(int argc, char *argv[])
 	}
 
 	dt_io_clear_zones();
+	dt_io_clear_bizcal();
 	if (argi->from_locale_arg) {
 		setilocale(NULL);
 	}
 
 out:
+	dt_io_stats_fini();
 	yuck_free(argi);
 	return rc;
 }
@@ -37,10 +37,15 @@
 #if defined HAVE_CONFIG_H
 # include "config.h"
 #endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
 #include <sys/time.h>
+#include <sys/wait.h>
 #include <time.h>
 
 #include "dt-core.h"
@@ -61,10 +66,23 @@ struct prln_ctx_s {
 	dexpr_t root;
 	zif_t fromz;
 	zif_t z;
+	/* file name to prefix matches with, or NULL */
+	const char *fn;
+	size_t fnz;
 	unsigned int only_matching_p:1U;
 	unsigned int invert_match_p:1U;
 };
 
+static inline void
+prnt_fn(struct prln_ctx_s ctx)
+{
+	if (ctx.fn != NULL) {
+		__io_write(ctx.fn, ctx.fnz, stdout);
+		__io_putc(':', stdout);
+	}
+	return;
+}
+
 static void
 proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
 {
@@ -98,6 +116,7 @@ proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
 			}
 			/* make sure we finish the line */
 			*ep++ = '\n';
+			prnt_fn(ctx);
 			__io_write(sp, ep - sp, stdout);
 			return;
 		}
@@ -114,11 +133,154 @@ proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
 		}
 		/* finish the line and bugger off */
 		*oep++ = '\n';
+		prnt_fn(ctx);
 		__io_write(osp, oep - osp, stdout);
 	}
 	return;
 }
 
+static int
+proc_file(struct prln_ctx_s prln, const char *fn)
+{
+	void *pctx;
+	pid_t dec;
+	int fd;
+
+	if ((fd = dt_io_open(fn, &dec)) < 0) {
+		return -1;
+	}
+
+	/* using the prchunk reader now */
+	if ((pctx = init_prchunk_r(fd)) == NULL) {
+		serror("Error: cannot read from `%s'", fn ?: "<stdin>");
+		dt_io_close(fd, dec);
+		return -1;
+	}
+
+	while (prchunk_fill(pctx) >= 0) {
+		for (char *line; prchunk_haslinep(pctx);) {
+			size_t llen = prchunk_getline(pctx, &line);
+
+			proc_line(prln, line, llen);
+		}
+	}
+	/* get rid of resources */
+	free_prchunk_r(pctx);
+	return dt_io_close(fd, dec);
+}
+
+static int
+proc_fn(struct prln_ctx_s prln, const char *fn, bool hdrp)
+{
+	if (hdrp) {
+		prln.fn = fn && strcmp(fn, "-") ? fn : "(standard input)";
+		prln.fnz = strlen(prln.fn);
+	}
+	return proc_file(prln, fn);
+}
+
+/* one worker process per file, output goes through a pipe so that
+ * matches can be handed on in the order of the files */
+struct wrk_s {
+	pid_t pid;
+	int fd;
+};
+
+static void
+spawn_wrk(
+	struct wrk_s *restrict w, size_t slot,
+	struct prln_ctx_s prln, const char *fn, bool hdrp)
+{
+	int pfd[2];
+
+	w->pid = -1;
+	w->fd = -1;
+	if (pipe(pfd) < 0) {
+		return;
+	}
+	/* don't hand pending output to the child */
+	fflush(stdout);
+	switch ((w->pid = fork())) {
+	case -1:
+		/* parent will do it */
+		close(pfd[0]);
+		close(pfd[1]);
+		return;
+	case 0: {
+		/* i am the child */
+		int rc;
+
+		close(pfd[0]);
+		dup2(pfd[1], STDOUT_FILENO);
+		close(pfd[1]);
+		dt_io_stats_slot(slot);
+		rc = proc_fn(prln, fn, hdrp);
+		fflush(stdout);
+		dt_io_stats_sync();
+		_exit(rc < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+	}
+	default:
+		close(pfd[1]);
+		w->fd = pfd[0];
+		return;
+	}
+}
+
+static int
+reap_wrk(struct wrk_s *restrict w)
+{
+	char buf[16384U];
+	int st;
+
+	for (ssize_t nrd; (nrd = read(w->fd, buf, sizeof(buf))) != 0;) {
+		if (nrd > 0) {
+			/* the worker has accounted for this already */
+			fwrite(buf, 1U, nrd, stdout);
+		} else if (errno != EINTR) {
+			break;
+		}
+	}
+	close(w->fd);
+	while (waitpid(w->pid, &st, 0) != w->pid);
+	return WIFEXITED(st) && !WEXITSTATUS(st) ? 0 : -1;
+}
+
+static int
+proc_files(
+	struct prln_ctx_s prln, char *const fns[], size_t nfn,
+	bool hdrp, unsigned int njobs)
+{
+	struct wrk_s *w;
+	int rc = 0;
+
+	if (njobs <= 1U || nfn <= 1U ||
+	    (w = calloc(nfn, sizeof(*w))) == NULL) {
+		for (size_t i = 0U; i < nfn; i++) {
+			if (proc_fn(prln, fns[i], hdrp) < 0) {
+				rc = -1;
+			}
+		}
+		return rc;
+	}
+	/* keep NJOBS workers busy, drain them in file order */
+	for (size_t i = 0U, j = 0U; i < nfn; i++) {
+		for (; j < nfn && j - i < njobs; j++) {
+			/* workers at most NJOBS apart never overlap */
+			spawn_wrk(w + j, 1U + j % njobs, prln, fns[j], hdrp);
+		}
+		if (w[i].pid < 0) {
+			/* no worker, do it ourselves */
+			if (proc_fn(prln, fns[i], hdrp) < 0) {
+				rc = -1;
+			}
+		} else if (reap_wrk(w + i) < 0) {
+			rc = -1;
+		}
+	}
+	free(w);
+	return rc;
+}
+
 
 #include "dgrep.yucc"
 
@@ -130,6 +292,7 @@ main(int argc, char *argv[])
 	size_t nfmt;
 	dexpr_t root;
 	oper_t o = OP_UNK;
+	unsigned int njobs;
 	int res = 0;
 
 	if (yuck_parse(argi, argc, argv)) {
@@ -149,6 +312,31 @@ main(int argc, char *argv[])
 		struct dt_dt_s base = dt_strpdt(argi->base_arg, NULL, NULL);
 		dt_set_base(base);
 	}
+	if (argi->jobs_arg) {
+		char *on;
+		unsigned long j = strtoul(argi->jobs_arg, &on, 10);
+
+		if (*on || !j) {
+			error("Error: invalid number of jobs `%s'",
+			      argi->jobs_arg);
+			res = 1;
+			goto out;
+		}
+		njobs = j < UINT_MAX ? (unsigned int)j : UINT_MAX;
+	} else {
+		long j = sysconf(_SC_NPROCESSORS_ONLN);
+		njobs = j > 0 ? (unsigned int)j : 1U;
+	}
+	if (argi->stats_arg) {
+		const char *how = argi->stats_arg != YUCK_OPTARG_NONE
+			? argi->stats_arg : NULL;
+
+		/* slot 0 for us, one for each concurrent worker */
+		if (dt_io_stats_init(how, fmt, nfmt, njobs + 1U) < 0) {
+			res = 1;
+			goto out;
+		}
+	}
 
 	if (argi->eq_flag) {
 		o = OP_EQ;
@@ -190,12 +378,10 @@ with complex expressions");
 	dexpr_simplify(root);
 	/* beef */
 	{
-		/* read from stdin */
-		size_t lno = 0;
+		/* process all files */
 		struct grep_atom_s __nstk[16], *needle = __nstk;
 		size_t nneedle = countof(__nstk);
 		struct grep_atom_soa_s ndlsoa;
-		void *pctx;
 		struct prln_ctx_s prln = {
 			.ndl = &ndlsoa,
 			.root = root,
@@ -217,21 +403,13 @@ with complex expressions");
 		/* and now build the needle */
 		ndlsoa = build_needle(needle, nneedle, fmt, nfmt);
 
-		/* using the prchunk reader now */
-		if ((pctx = init_prchunk(STDIN_FILENO)) == NULL) {
-			serror("Error: could not open stdin");
-			goto ndl_free;
-		}
-		while (prchunk_fill(pctx) >= 0) {
-			for (char *line; prchunk_haslinep(pctx); lno++) {
-				size_t llen = prchunk_getline(pctx, &line);
-
-				proc_line(prln, line, llen);
+		with (size_t nfn = argi->nargs > 1U ? argi->nargs - 1U : 1U) {
+			if (proc_files(prln, argi->args + 1U, nfn,
+				       argi->with_filename_flag, njobs) < 0) {
+				res = 1;
 			}
 		}
-		/* get rid of resources */
-		free_prchunk(pctx);
-	ndl_free:
+
 		if (needle != __nstk) {
 			free(needle);
 		}
@@ -243,6 +421,7 @@ with complex expressions");
 		setilocale(NULL);
 	}
 out:
+	dt_io_stats_fini();
 	yuck_free(argi);
 	return res;
 }
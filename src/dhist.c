@@ -0,0 +1,530 @@
+/*** dhist.c -- count date/times by rounding buckets
+ *
+ * Copyright (C) 2019 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of dateutils.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dt-core.h"
+#include "dt-io.h"
+#include "dt-core-tz-glue.h"
+#include "dt-locale.h"
+#include "prchunk.h"
+/* the rounding business, shared with dround */
+#include "dround.c"
+
+const char *prog = "dhist";
+
+/* initial number of hash slots, must be a power of 2 */
+#define INI_NBKT	(1024U)
+
+struct bkey_s {
+	int64_t s;
+	uint32_t ns;
+	/* 0 for dates, 1 for times, 2 for date/times */
+	uint32_t kind;
+};
+
+struct bkt_s {
+	struct bkey_s k;
+	size_t cnt;
+	/* the rounded date/time, as printed */
+	struct dt_dt_s d;
+	/* oldest and youngest date/time in the bucket, if asked for */
+	struct dt_dt_s min;
+	struct dt_dt_s max;
+	struct bkey_s mink;
+	struct bkey_s maxk;
+	/* first and last line in the bucket, if asked for */
+	char *fst;
+	char *lst;
+	size_t lstz;
+};
+
+struct hist_s {
+	/* open-addressed, linear probing, empty slots have cnt == 0 */
+	struct bkt_s *b;
+	size_t nb;
+	size_t n;
+	/* slot of the last hit, log files tend to be in order */
+	size_t last;
+};
+
+
+static struct bkey_s
+bkey(struct dt_dt_s d)
+{
+	if (dt_sandwich_only_t_p(d)) {
+		/* dt_io_dt2ts() has no business with these */
+		return (struct bkey_s){
+			.s = (d.t.hms.h * MINS_PER_HOUR + d.t.hms.m) *
+				SECS_PER_MIN + d.t.hms.s,
+			.ns = d.t.hms.ns,
+			.kind = 1U,
+		};
+	}
+	const struct dt_io_ts_s ts = dt_io_dt2ts(d);
+
+	return (struct bkey_s){
+		.s = ts.s,
+		.ns = ts.ns,
+		.kind = dt_sandwich_only_d_p(d) ? 0U : 2U,
+	};
+}
+
+static inline bool
+bkey_eq_p(struct bkey_s k1, struct bkey_s k2)
+{
+	return k1.s == k2.s && k1.ns == k2.ns && k1.kind == k2.kind;
+}
+
+static inline size_t
+bkey_hash(struct bkey_s k, size_t nb)
+{
+	uint64_t h = (uint64_t)k.s ^ ((uint64_t)k.ns << 30U) ^ k.kind;
+
+	/* fibonacci hashing, NB is a power of 2 */
+	h *= 0x9e3779b97f4a7c15ULL;
+	return (size_t)(h >> 32U) & (nb - 1U);
+}
+
+static int
+bkey_cmp(struct bkey_s k1, struct bkey_s k2)
+{
+	if (k1.kind != k2.kind) {
+		return k1.kind < k2.kind ? -1 : 1;
+	} else if (k1.s != k2.s) {
+		return k1.s < k2.s ? -1 : 1;
+	} else if (k1.ns != k2.ns) {
+		return k1.ns < k2.ns ? -1 : 1;
+	}
+	return 0;
+}
+
+static int
+bkt_cmp(const void *x, const void *y)
+{
+	const struct bkt_s *b1 = x;
+	const struct bkt_s *b2 = y;
+
+	return bkey_cmp(b1->k, b2->k);
+}
+
+static int
+hist_grow(struct hist_s *h)
+{
+	const size_t nb = h->nb ? h->nb * 2U : INI_NBKT;
+	struct bkt_s *b;
+
+	if (UNLIKELY((b = calloc(nb, sizeof(*b))) == NULL)) {
+		return -1;
+	}
+	for (size_t i = 0U; i < h->nb; i++) {
+		size_t j;
+
+		if (!h->b[i].cnt) {
+			continue;
+		}
+		for (j = bkey_hash(h->b[i].k, nb); b[j].cnt; j = (j + 1U) & (nb - 1U));
+		b[j] = h->b[i];
+	}
+	free(h->b);
+	h->b = b;
+	h->nb = nb;
+	h->last = 0U;
+	return 0;
+}
+
+static struct bkt_s*
+hist_get(struct hist_s *h, struct bkey_s k)
+{
+/* return the bucket for K, a fresh one has cnt == 0 */
+	size_t i;
+
+	if (LIKELY(h->b[h->last].cnt) && bkey_eq_p(h->b[h->last].k, k)) {
+		return h->b + h->last;
+	} else if (UNLIKELY(2U * (h->n + 1U) > h->nb) &&
+		   UNLIKELY(hist_grow(h) < 0)) {
+		return NULL;
+	}
+	for (i = bkey_hash(k, h->nb);
+	     h->b[i].cnt && !bkey_eq_p(h->b[i].k, k);
+	     i = (i + 1U) & (h->nb - 1U));
+	if (!h->b[i].cnt) {
+		h->b[i].k = k;
+		h->n++;
+	}
+	h->last = i;
+	return h->b + i;
+}
+
+static void
+free_hist(struct hist_s *h)
+{
+	for (size_t i = 0U; i < h->nb; i++) {
+		if (h->b[i].fst != NULL) {
+			free(h->b[i].fst);
+		}
+		if (h->b[i].lst != NULL) {
+			free(h->b[i].lst);
+		}
+	}
+	free(h->b);
+	return;
+}
+
+static char*
+keep_line(char *buf, size_t *bsz, const char *line, size_t llen)
+{
+/* copy LINE into BUF (of size *BSZ) growing it as need be */
+	if (llen >= *bsz) {
+		size_t nsz = *bsz ?: 64U;
+		char *nu;
+
+		while ((nsz *= 2U) <= llen);
+		if (UNLIKELY((nu = realloc(buf, nsz)) == NULL)) {
+			return buf;
+		}
+		buf = nu;
+		*bsz = nsz;
+	}
+	memcpy(buf, line, llen);
+	buf[llen] = '\0';
+	return buf;
+}
+
+
+struct prln_ctx_s {
+	struct grep_atom_soa_s *ndl;
+	zif_t fromz;
+	int quietp;
+	bool minp;
+	bool maxp;
+	bool firstp;
+	bool lastp;
+
+	const struct rnd_s *rnd;
+	struct hist_s *hist;
+};
+
+static int
+proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
+{
+	struct dt_dt_s d;
+	struct dt_dt_s r;
+	struct bkt_s *b;
+	char *sp = NULL;
+	char *ep = NULL;
+	int rc = 0;
+
+	d = dt_io_find_strpdt2(line, llen, ctx.ndl, &sp, &ep, ctx.fromz);
+	if (dt_unk_p(d)) {
+		/* obviously unmatched, warn about it in non -q mode */
+		if (!ctx.quietp) {
+			dt_io_warn_strpdt(line);
+			rc = 2;
+		}
+		return rc;
+	} else if (UNLIKELY(d.fix) && !ctx.quietp) {
+		rc = 2;
+	}
+	/* round, just like dround does */
+	if (UNLIKELY(dt_unk_p(r = dround(d, ctx.rnd)))) {
+		return rc;
+	} else if (ctx.fromz != NULL) {
+		/* fixup zone */
+		r = dtz_forgetz(r, ctx.fromz);
+	}
+
+	if (UNLIKELY((b = hist_get(ctx.hist, bkey(r))) == NULL)) {
+		error("Error: cannot grow bucket table");
+		return -1;
+	} else if (!b->cnt++) {
+		b->d = r;
+		if (ctx.minp || ctx.maxp) {
+			b->min = b->max = d;
+			b->mink = b->maxk = bkey(d);
+		}
+		if (ctx.firstp) {
+			size_t z = 0U;
+			b->fst = keep_line(NULL, &z, line, llen);
+		}
+	} else if (ctx.minp || ctx.maxp) {
+		const struct bkey_s k = bkey(d);
+
+		if (bkey_cmp(k, b->mink) < 0) {
+			b->min = d;
+			b->mink = k;
+		} else if (bkey_cmp(k, b->maxk) > 0) {
+			b->max = d;
+			b->maxk = k;
+		}
+	}
+	if (ctx.lastp) {
+		b->lst = keep_line(b->lst, &b->lstz, line, llen);
+	}
+	return rc;
+}
+
+static void
+prnt_hist(struct prln_ctx_s ctx, const char *ofmt, zif_t z)
+{
+	struct hist_s *h = ctx.hist;
+	size_t nb = 0U;
+
+	/* compact the table then sort it, it's no good as hash table after */
+	for (size_t i = 0U; i < h->nb; i++) {
+		if (!h->b[i].cnt) {
+			continue;
+		} else if (i > nb) {
+			h->b[nb] = h->b[i];
+			memset(h->b + i, 0, sizeof(*h->b));
+		}
+		nb++;
+	}
+	qsort(h->b, nb, sizeof(*h->b), bkt_cmp);
+
+	for (size_t i = 0U; i < nb; i++) {
+		const struct bkt_s *b = h->b + i;
+		char buf[32U];
+		size_t n;
+
+		dt_io_write(b->d, ofmt, z, '\0');
+		n = snprintf(buf, sizeof(buf), "\t%zu", b->cnt);
+		__io_write(buf, n, stdout);
+		if (ctx.minp) {
+			__io_putc('\t', stdout);
+			dt_io_write(b->min, ofmt, z, '\0');
+		}
+		if (ctx.maxp) {
+			__io_putc('\t', stdout);
+			dt_io_write(b->max, ofmt, z, '\0');
+		}
+		if (ctx.firstp) {
+			__io_putc('\t', stdout);
+			if (LIKELY(b->fst != NULL)) {
+				__io_write(b->fst, strlen(b->fst), stdout);
+			}
+		}
+		if (ctx.lastp) {
+			__io_putc('\t', stdout);
+			if (LIKELY(b->lst != NULL)) {
+				__io_write(b->lst, strlen(b->lst), stdout);
+			}
+		}
+		__io_putc('\n', stdout);
+	}
+	return;
+}
+
+
+#include "dhist.yucc"
+
+int
+main(int argc, char *argv[])
+{
+	yuck_t argi[1U];
+	struct __strpdtdur_st_s st = {0};
+	struct rnd_s rnd = {NULL};
+	struct hist_s hist = {NULL};
+	struct grep_atom_s __nstk[16], *needle = __nstk;
+	size_t nneedle = countof(__nstk);
+	struct grep_atom_soa_s ndlsoa;
+	struct prln_ctx_s prln;
+	void *pctx;
+	const char *ofmt;
+	char **fmt;
+	size_t nfmt;
+	int rc = 0;
+	zif_t fromz = NULL;
+	zif_t z = NULL;
+
+	if (yuck_parse(argi, argc, argv)) {
+		rc = 1;
+		goto out;
+	} else if (argi->nargs == 0U) {
+		error("Error: RNDSPEC must be specified\n");
+		yuck_auto_help(argi);
+		rc = 1;
+		goto out;
+	}
+	/* init and unescape sequences, maybe */
+	ofmt = argi->format_arg;
+	fmt = argi->input_format_args;
+	nfmt = argi->input_format_nargs;
+	if (argi->backslash_escapes_flag) {
+		dt_io_unescape(argi->format_arg);
+		for (size_t i = 0; i < nfmt; i++) {
+			dt_io_unescape(fmt[i]);
+		}
+	}
+	if (argi->stats_arg) {
+		const char *how = argi->stats_arg != YUCK_OPTARG_NONE
+			? argi->stats_arg : NULL;
+
+		if (dt_io_stats_init(how, fmt, nfmt, 1U) < 0) {
+			rc = 1;
+			goto out;
+		}
+	}
+
+	if (argi->from_locale_arg) {
+		setilocale(argi->from_locale_arg);
+	}
+	if (argi->locale_arg) {
+		setflocale(argi->locale_arg);
+	}
+
+	/* try and read the from and to time zones */
+	if (argi->from_zone_arg) {
+		fromz = dt_io_zone(argi->from_zone_arg);
+	}
+	if (argi->zone_arg) {
+		z = dt_io_zone(argi->zone_arg);
+	}
+	if (argi->base_arg) {
+		struct dt_dt_s base = dt_strpdt(argi->base_arg, NULL, NULL);
+		dt_set_base(base);
+	}
+
+	for (size_t i = 0U; i < argi->nargs; i++) {
+		switch (rndspec(&st, argi->args[i])) {
+		case -1:
+			serror("Error: \
+cannot parse duration/rounding string `%s'", st.istr);
+			/*@fallthrough@*/
+		case -2:
+			rc = 1;
+			goto clear;
+		default:
+			break;
+		}
+	}
+
+	/* compile the rounding chain */
+	rnd = (struct rnd_s){
+		.durs = st.durs,
+		.ndurs = st.ndurs,
+		.per = make_per(st.durs, st.ndurs),
+		.nextp = argi->next_flag,
+	};
+
+	if (UNLIKELY(hist_grow(&hist) < 0)) {
+		serror("Error: cannot allocate bucket table");
+		rc = 1;
+		goto clear;
+	}
+
+	/* no threads reading this stream */
+	__io_setlocking_bycaller(stdout);
+
+	/* lest we overflow the stack */
+	if (nfmt >= nneedle) {
+		/* round to the nearest 8-multiple */
+		nneedle = (nfmt | 7) + 1;
+		needle = calloc(nneedle, sizeof(*needle));
+	}
+	/* and now build the needle */
+	ndlsoa = build_needle(needle, nneedle, fmt, nfmt);
+
+	/* read from stdin, using the prchunk reader */
+	if ((pctx = init_prchunk(STDIN_FILENO)) == NULL) {
+		serror("Error: could not open stdin");
+		rc = 1;
+		goto ndl_free;
+	}
+	prln = (struct prln_ctx_s){
+		.ndl = &ndlsoa,
+		.fromz = fromz,
+		.quietp = argi->quiet_flag,
+		.minp = argi->min_flag,
+		.maxp = argi->max_flag,
+		.firstp = argi->first_flag,
+		.lastp = argi->last_flag,
+		.rnd = &rnd,
+		.hist = &hist,
+	};
+	while (rc != 1 && prchunk_fill(pctx) >= 0) {
+		while (prchunk_haslinep(pctx)) {
+			char *line;
+			size_t llen = prchunk_getline(pctx, &line);
+			const int lrc = proc_line(prln, line, llen);
+
+			if (UNLIKELY(lrc < 0)) {
+				/* no point in going on */
+				rc = 1;
+				break;
+			}
+			rc |= lrc;
+		}
+	}
+	/* get rid of resources */
+	free_prchunk(pctx);
+
+	/* and now for the result */
+	prnt_hist(prln, ofmt, z);
+
+ndl_free:
+	if (needle != __nstk) {
+		free(needle);
+	}
+clear:
+	/* free the strpdur status */
+	__strpdtdur_free(&st);
+	free(rnd.per);
+	free_hist(&hist);
+
+	dt_io_clear_zones();
+	if (argi->from_locale_arg) {
+		setilocale(NULL);
+	}
+	if (argi->locale_arg) {
+		setflocale(NULL);
+	}
+
+out:
+	dt_io_stats_fini();
+	yuck_free(argi);
+	return rc;
+}
+
+/* dhist.c ends here */
@@ -56,8 +56,6 @@
 # define assert(x)
 #endif	/* !assert */
 
-const char *prog = "dround";
-
 
 static struct dt_t_s
 tround_tdur_cocl(struct dt_t_s t, struct dt_dtdur_s dur, bool nextp)
@@ -662,16 +660,129 @@ Epoch date/times have no divisions to round to.");
 		/* just keep it sexy */
 		d.sexy = sxround_dur_cocl(d.sexy, dur, nextp);
 		break;
+	case DT_NSEXY:
+		/* round in calendric space, hand back nanoseconds */
+		with (struct dt_dt_s x = dt_dtconv((dt_dttyp_t)DT_YMD, d)) {
+			x = dt_round(x, dur, nextp);
+			d = dt_dtconv(DT_NSEXY, x);
+		}
+		break;
 	}
 	return d;
 }
 
 
+struct rnd_s {
+	const struct dt_dtdur_s *durs;
+	size_t ndurs;
+	/* the same chain as periods in seconds, negative when rounding
+	 * down, if all of them are sub-day co-classes, NULL otherwise */
+	int32_t *per;
+	bool nextp;
+};
+
+static int32_t*
+make_per(const struct dt_dtdur_s *durs, size_t ndurs)
+{
+/* compile DURS into periods if they're all sub-day co-classes,
+ * option parsing made sure they subdivide a day */
+	int32_t *res;
+
+	for (size_t i = 0U; i < ndurs; i++) {
+		if (!durs[i].cocl || !durs[i].dv) {
+			return NULL;
+		}
+		switch (durs[i].durtyp) {
+		case DT_DURH:
+		case DT_DURM:
+		case DT_DURS:
+			continue;
+		default:
+			return NULL;
+		}
+	}
+	if (UNLIKELY(!ndurs || (res = malloc(ndurs * sizeof(*res))) == NULL)) {
+		return NULL;
+	}
+	for (size_t i = 0U; i < ndurs; i++) {
+		int32_t p = durs[i].dv;
+		bool downp = p < 0 || durs[i].neg;
+
+		p = p < 0 ? -p : p;
+		switch (durs[i].durtyp) {
+		case DT_DURH:
+			p *= MINS_PER_HOUR;
+			/*@fallthrough@*/
+		case DT_DURM:
+			p *= SECS_PER_MIN;
+			/*@fallthrough@*/
+		default:
+			break;
+		}
+		res[i] = downp ? -p : p;
+	}
+	return res;
+}
+
 static struct dt_dt_s
-dround(struct dt_dt_s d, struct dt_dtdur_s dur[], size_t ndur, bool nextp)
+dround_per(struct dt_dt_s d, const int32_t *per, size_t nper, bool nextp)
 {
-	for (size_t i = 0; i < ndur; i++) {
-		d = dt_round(d, dur[i], nextp);
+/* like successive tround_tdur_cocl() but on seconds since midnight,
+ * the periods divide a day, so carries can be settled once at the end */
+	int32_t tunp;
+	bool chgp = false;
+
+	tunp = (d.t.hms.h * MINS_PER_HOUR + d.t.hms.m) * SECS_PER_MIN +
+		d.t.hms.s;
+	for (size_t i = 0U; i < nper; i++) {
+		const bool downp = per[i] < 0;
+		const int32_t p = downp ? -per[i] : per[i];
+		/* tunp might be negative by now, we want the floor */
+		const int32_t diff = (tunp % p + p) % p;
+
+		if (!diff && !nextp) {
+			/* leave the slots alone, see tround_tdur_cocl() */
+			continue;
+		} else if (!downp) {
+			tunp += p - diff;
+		} else if (!diff) {
+			tunp -= p;
+		} else {
+			tunp -= diff;
+		}
+		chgp = true;
+	}
+	if (!chgp) {
+		return d;
+	}
+	with (int32_t carry = tunp / (int32_t)SECS_PER_DAY) {
+		if ((tunp %= (int32_t)SECS_PER_DAY) < 0) {
+			tunp += SECS_PER_DAY;
+			carry--;
+		}
+		if (carry) {
+			d.d = dt_dadd(d.d, dt_make_ddur(DT_DURD, carry));
+		}
+	}
+	d.t.hms.ns = 0;
+	d.t.hms.s = tunp % SECS_PER_MIN;
+	tunp /= SECS_PER_MIN;
+	d.t.hms.m = tunp % MINS_PER_HOUR;
+	tunp /= MINS_PER_HOUR;
+	d.t.hms.h = tunp;
+	return d;
+}
+
+static struct dt_dt_s
+dround(struct dt_dt_s d, const struct rnd_s *r)
+{
+	if (r->per != NULL && d.typ != DT_SEXY && d.typ != DT_SEXYTAI &&
+	    dt_sandwich_p(d)) {
+		/* fast path for bucketing into hours, minutes, seconds */
+		return dround_per(d, r->per, r->ndurs, r->nextp);
+	}
+	for (size_t i = 0; i < r->ndurs; i++) {
+		d = dt_round(d, r->durs[i], r->nextp);
 	}
 	return d;
 }
@@ -747,16 +858,139 @@ out:
 	return __add_dur(st, payload);
 }
 
+static int
+rndspec(struct __strpdtdur_st_s *st, const char *inp)
+{
+/* read all RNDSPECs in INP into ST and check them,
+ * return -1 if INP cannot be read, -2 if a RNDSPEC is out of range */
+	do {
+#define LAST_DUR	(st->durs[st->ndurs - 1])
+		if (dt_io_strpdtrnd(st, inp) < 0) {
+			return -1;
+		} else if (LAST_DUR.cocl) {
+			switch (LAST_DUR.durtyp) {
+			case DT_DURH:
+				if (!LAST_DUR.dv ||
+				    HOURS_PER_DAY % LAST_DUR.dv) {
+					goto nococl;
+				}
+				break;
+			case DT_DURM:
+				if (!LAST_DUR.dv ||
+				    MINS_PER_HOUR % LAST_DUR.dv) {
+					goto nococl;
+				}
+				break;
+			case DT_DURS:
+				if (!LAST_DUR.dv ||
+				    SECS_PER_MIN % LAST_DUR.dv) {
+					goto nococl;
+				}
+				break;
+
+			case DT_DURD:
+			case DT_DURBD:
+				if (LAST_DUR.d.dv != 1 &&
+				    LAST_DUR.d.dv != -1) {
+					goto nococl;
+				}
+				break;
+			case DT_DURMO:
+				/* make a millenium the next milestone */
+				if (!LAST_DUR.d.dv ||
+				    12000 % LAST_DUR.d.dv) {
+					goto nococl;
+				}
+				break;
+			case DT_DURQU:
+				/* make a millenium the next milestone */
+				if (!LAST_DUR.d.dv ||
+				    4000 % LAST_DUR.d.dv) {
+					goto nococl;
+				}
+				break;
+			case DT_DURYR:
+				/* make a millenium the next milestone */
+				if (!LAST_DUR.d.dv ||
+				    1000 % LAST_DUR.d.dv) {
+					goto nococl;
+				}
+				break;
+
+			nococl:
+				error("\
+Error: subdivisions must add up to whole divisions");
+				return -2;
+			}
+		} else {
+			switch (LAST_DUR.durtyp) {
+			case DT_DURH:
+				if (LAST_DUR.dv >= 24 ||
+				    LAST_DUR.dv <= -24) {
+					goto range;
+				}
+				break;
+			case DT_DURM:
+				if (LAST_DUR.dv >= 60 ||
+				    LAST_DUR.dv <= -60) {
+					goto range;
+				}
+				break;
+			case DT_DURS:
+				if (LAST_DUR.dv >= 60 ||
+				    LAST_DUR.dv <= -60) {
+					goto range;
+				}
+				break;
+			case DT_DURMO:
+				if (!LAST_DUR.d.dv ||
+				    LAST_DUR.d.dv > 12 ||
+				    LAST_DUR.d.dv < -12) {
+					goto range;
+				}
+				break;
+			case DT_DURQU:
+				if (!LAST_DUR.d.dv ||
+				    LAST_DUR.d.dv > 4 ||
+				    LAST_DUR.d.dv < -4) {
+					goto range;
+				}
+				break;
+			case DT_DURYR:
+				serror("\
+Error: Gregorian years are non-recurrent.\n\
+Did you mean year class rounding?  Try `/%s'", inp);
+				return -2;
+			default:
+				break;
+
+			range:
+				serror("\
+Error: rounding parameter out of range `%s'", inp);
+				return -2;
+			}
+		}
+#undef LAST_DUR
+	} while (__strpdtdur_more_p(st));
+	return 0;
+}
+
+
+#if defined STANDALONE
+const char *prog = "dround";
+
 struct prln_ctx_s {
 	struct grep_atom_soa_s *ndl;
+	const struct dt_io_cols_s *cols;
+	char *const *fmt;
+	size_t nfmt;
 	const char *ofmt;
 	zif_t fromz;
 	zif_t outz;
 	int sed_mode_p;
 	int quietp;
 
-	const struct __strpdtdur_st_s *st;
-	bool nextp;
+	const struct rnd_s *rnd;
 };
 
 static int
@@ -777,7 +1011,7 @@ proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
 				rc = 2;
 			}
 			/* perform addition now */
-			d = dround(d, ctx.st->durs, ctx.st->ndurs, ctx.nextp);
+			d = dround(d, ctx.rnd);
 
 			if (ctx.fromz != NULL) {
 				/* fixup zone */
@@ -809,6 +1043,55 @@ proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
 	return rc;
 }
 
+static int
+proc_cols(struct prln_ctx_s ctx, void *pctx, int lno)
+{
+	const struct dt_io_cols_s *cols = ctx.cols;
+	int rc = 0;
+
+	for (unsigned int i = 0U; i < cols->ncols; i++) {
+		char *fld;
+		size_t flen = prchunk_getcolno(pctx, &fld, lno, i);
+		struct dt_dt_s d;
+		char *ep = NULL;
+
+		if (UNLIKELY(fld == NULL)) {
+			/* line's got fewer columns */
+			break;
+		} else if (i) {
+			__io_putc(cols->dlm, stdout);
+		}
+		if (!dt_io_col_p(cols, i)) {
+			/* not interested */
+			;
+		} else if (!dt_unk_p(d = dt_io_strpdt_ep(
+					     fld, ctx.fmt, ctx.nfmt,
+					     &ep, ctx.fromz))) {
+			if (UNLIKELY(d.fix) && !ctx.quietp) {
+				rc = 2;
+			}
+			/* perform rounding now */
+			d = dround(d, ctx.rnd);
+
+			if (ctx.fromz != NULL) {
+				/* fixup zone */
+				d = dtz_forgetz(d, ctx.fromz);
+			}
+			dt_io_write(d, ctx.ofmt, ctx.outz, '\0');
+			/* copy the rest of the field */
+			flen -= ep - fld;
+			fld = ep;
+		} else if (!ctx.quietp) {
+			/* unmatched, warn about it like in line mode */
+			dt_io_warn_strpdt(fld);
+			rc = 2;
+		}
+		__io_write(fld, flen, stdout);
+	}
+	__io_putc('\n', stdout);
+	return rc;
+}
+
 
 #include "dround.yucc"
 
@@ -818,6 +1101,7 @@ main(int argc, char *argv[])
 	yuck_t argi[1U];
 	struct dt_dt_s d;
 	struct __strpdtdur_st_s st = {0};
+	struct rnd_s rnd = {NULL};
 	char *inp;
 	const char *ofmt;
 	char **fmt;
@@ -847,6 +1131,15 @@ main(int argc, char *argv[])
 			dt_io_unescape(fmt[i]);
 		}
 	}
+	if (argi->stats_arg) {
+		const char *how = argi->stats_arg != YUCK_OPTARG_NONE
+			? argi->stats_arg : NULL;
+
+		if (dt_io_stats_init(how, fmt, nfmt, 1U) < 0) {
+			rc = 1;
+			goto out;
+		}
+	}
 
 	if (argi->from_locale_arg) {
 		setilocale(argi->from_locale_arg);
@@ -875,126 +1168,23 @@ main(int argc, char *argv[])
 	dt_given_p = !dt_unk_p(d = dt_io_strpdt(*argi->args, fmt, nfmt, NULL));
 	for (size_t i = dt_given_p; i < argi->nargs; i++) {
 		inp = argi->args[i];
-		do {
-#define LAST_DUR	(st.durs[st.ndurs - 1])
-			if (dt_io_strpdtrnd(&st, inp) < 0) {
-				if (UNLIKELY(i == 0)) {
-					/* that's ok, must be a date then */
-					dt_given_p = true;
-				} else {
-					serror("Error: \
-cannot parse duration/rounding string `%s'", st.istr);\
-					rc = 1;
-					goto out;
-				}
-			} else if (LAST_DUR.cocl) {
-				switch (LAST_DUR.durtyp) {
-				case DT_DURH:
-					if (!LAST_DUR.dv ||
-					    HOURS_PER_DAY % LAST_DUR.dv) {
-						goto nococl;
-					}
-					break;
-				case DT_DURM:
-					if (!LAST_DUR.dv ||
-					    MINS_PER_HOUR % LAST_DUR.dv) {
-						goto nococl;
-					}
-					break;
-				case DT_DURS:
-					if (!LAST_DUR.dv ||
-					    SECS_PER_MIN % LAST_DUR.dv) {
-						goto nococl;
-					}
-					break;
-
-				case DT_DURD:
-				case DT_DURBD:
-					if (LAST_DUR.d.dv != 1 &&
-					    LAST_DUR.d.dv != -1) {
-						goto nococl;
-					}
-					break;
-				case DT_DURMO:
-					/* make a millenium the next milestone */
-					if (!LAST_DUR.d.dv ||
-					    12000 % LAST_DUR.d.dv) {
-						goto nococl;
-					}
-					break;
-				case DT_DURQU:
-					/* make a millenium the next milestone */
-					if (!LAST_DUR.d.dv ||
-					    4000 % LAST_DUR.d.dv) {
-						goto nococl;
-					}
-					break;
-				case DT_DURYR:
-					/* make a millenium the next milestone */
-					if (!LAST_DUR.d.dv ||
-					    1000 % LAST_DUR.d.dv) {
-						goto nococl;
-					}
-					break;
-
-				nococl:
-					error("\
-Error: subdivisions must add up to whole divisions");
-					rc = 1;
-					goto out;
-				}
-			} else {
-				switch (LAST_DUR.durtyp) {
-				case DT_DURH:
-					if (LAST_DUR.dv >= 24 ||
-					    LAST_DUR.dv <= -24) {
-						goto range;
-					}
-					break;
-				case DT_DURM:
-					if (LAST_DUR.dv >= 60 ||
-					    LAST_DUR.dv <= -60) {
-						goto range;
-					}
-					break;
-				case DT_DURS:
-					if (LAST_DUR.dv >= 60 ||
-					    LAST_DUR.dv <= -60) {
-						goto range;
-					}
-					break;
-				case DT_DURMO:
-					if (!LAST_DUR.d.dv ||
-					    LAST_DUR.d.dv > 12 ||
-					    LAST_DUR.d.dv < -12) {
-						goto range;
-					}
-					break;
-				case DT_DURQU:
-					if (!LAST_DUR.d.dv ||
-					    LAST_DUR.d.dv > 4 ||
-					    LAST_DUR.d.dv < -4) {
-						goto range;
-					}
-					break;
-				case DT_DURYR:
-					serror("\
-Error: Gregorian years are non-recurrent.\n\
-Did you mean year class rounding?  Try `/%s'", inp);
-					rc = 1;
-					goto out;
-				default:
-					break;
-
-				range:
-					serror("\
-Error: rounding parameter out of range `%s'", inp);
-					rc = 1;
-					goto out;
-				}
+		switch (rndspec(&st, inp)) {
+		case -1:
+			if (UNLIKELY(i == 0)) {
+				/* that's ok, must be a date then */
+				dt_given_p = true;
+				break;
 			}
-#undef LAST_DUR
-		} while (__strpdtdur_more_p(&st));
+			serror("Error: \
+cannot parse duration/rounding string `%s'", st.istr);
+			rc = 1;
+			goto out;
+		case -2:
+			rc = 1;
+			goto out;
+		default:
+			break;
+		}
 	}
 
 	/* sanity checks */
@@ -1017,12 +1207,20 @@ no durations given");
 		goto out;
 	}
 
+	/* compile the rounding chain */
+	rnd = (struct rnd_s){
+		.durs = st.durs,
+		.ndurs = st.ndurs,
+		.per = make_per(st.durs, st.ndurs),
+		.nextp = nextp,
+	};
+
 	/* start the actual work */
 	if (dt_given_p) {
 		if (UNLIKELY(d.fix) && !argi->quiet_flag) {
 			rc = 2;
 		}
-		if (!dt_unk_p(d = dround(d, st.durs, st.ndurs, nextp))) {
+		if (!dt_unk_p(d = dround(d, &rnd))) {
 			if (fromz != NULL) {
 				/* fixup zone */
 				d = dtz_forgetz(d, fromz);
@@ -1062,7 +1260,7 @@ no durations given");
 					goto empty;
 				}
 				/* do the rounding */
-				d = dround(d, st.durs, st.ndurs, nextp);
+				d = dround(d, &rnd);
 				if (UNLIKELY(dt_unk_p(d))) {
 					goto empty;
 				}
@@ -1076,6 +1274,53 @@ no durations given");
 				__io_write("\n", 1U, stdout);
 			}
 		}
+	} else if (argi->key_arg) {
+		/* read from stdin, fields only */
+		struct dt_io_cols_s cols;
+		void *pctx;
+		struct prln_ctx_s prln = {
+			.cols = &cols,
+			.fmt = fmt,
+			.nfmt = nfmt,
+			.ofmt = ofmt,
+			.fromz = fromz,
+			.outz = z,
+			.quietp = argi->quiet_flag,
+			.rnd = &rnd,
+		};
+
+		if (argi->backslash_escapes_flag) {
+			dt_io_unescape(argi->delimiter_arg);
+		}
+		if (dt_io_cols(&cols, argi->delimiter_arg, argi->key_arg) < 0) {
+			rc = 1;
+			goto clear;
+		}
+
+		/* no threads reading this stream */
+		__io_setlocking_bycaller(stdout);
+
+		/* using the prchunk reader now */
+		if ((pctx = init_prchunk(STDIN_FILENO)) == NULL) {
+			serror("Error: could not open stdin");
+			goto clear;
+		}
+		while (prchunk_fill(pctx) >= 0) {
+			if (UNLIKELY(prchunk_rechunk(
+					     pctx, cols.dlm, cols.ncols) < 0)) {
+				error("Error: cannot split input into fields");
+				rc = 1;
+				break;
+			}
+			for (int i = 0; prchunk_haslinep(pctx); i++) {
+				char *line;
+
+				(void)prchunk_getline(pctx, &line);
+				rc |= proc_cols(prln, pctx, i);
+			}
+		}
+		/* get rid of resources */
+		free_prchunk(pctx);
 	} else {
 		/* read from stdin */
 		size_t lno = 0;
@@ -1090,8 +1335,7 @@ no durations given");
 			.outz = z,
 			.sed_mode_p = argi->sed_mode_flag,
 			.quietp = argi->quiet_flag,
-			.st = &st,
-			.nextp = nextp,
+			.rnd = &rnd,
 		};
 
 		/* no threads reading this stream */
@@ -1130,6 +1374,7 @@ no durations given");
 clear:
 	/* free the strpdur status */
 	__strpdtdur_free(&st);
+	free(rnd.per);
 
 	dt_io_clear_zones();
 	if (argi->from_locale_arg) {
@@ -1140,8 +1385,10 @@ clear:
 	}
 
 out:
+	dt_io_stats_fini();
 	yuck_free(argi);
 	return rc;
 }
+#endif	/* STANDALONE */
 
 /* dround.c ends here */
@@ -0,0 +1,660 @@
+/*** dserve.c -- serve date/time conversions on a unix socket
+ *
+ * Copyright (C) 2019 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of dateutils.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "dt-core.h"
+#include "dt-io.h"
+#include "dt-core-tz-glue.h"
+#include "dt-locale.h"
+
+
+const char *prog = "dserve";
+
+typedef enum {
+	REQ_UNK,
+	REQ_CONV,
+	REQ_ADD,
+} req_tool_t;
+
+/* a parsed request line, kept around for subsequent requests */
+struct req_s {
+	/* the request line as received, the cache key */
+	char *line;
+	size_t llen;
+	/* its fields, NUL separated */
+	char *buf;
+	req_tool_t tool;
+	char **fmt;
+	size_t nfmt;
+	const char *ofmt;
+	const char *iloc;
+	const char *floc;
+	zif_t fromz;
+	zif_t z;
+	/* durations for REQ_ADD and the zone to parse with */
+	struct __strpdtdur_st_s st;
+	zif_t hackz;
+};
+
+#define NCACHE	(16U)
+static struct req_s cache[NCACHE];
+static size_t cache_next;
+
+
+static bool
+durs_only_d_p(struct dt_dtdur_s dur[], size_t ndur)
+{
+	for (size_t i = 0; i < ndur; i++) {
+		if (dur[i].durtyp >= (dt_dtdurtyp_t)DT_NDURTYP) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void
+free_req(struct req_s *r)
+{
+	free(r->line);
+	free(r->buf);
+	free(r->fmt);
+	__strpdtdur_free(&r->st);
+	memset(r, 0, sizeof(*r));
+	return;
+}
+
+static int
+match_opt(
+	char *const *argv, size_t argc, size_t *i,
+	const char *so, const char *lo, char **val)
+{
+/* return 1 if ARGV[*I] is option SO or LO, with its value in VAL,
+ * 0 if it's not, and -1 if the value is missing */
+	char *a = argv[*i];
+	const size_t lz = strlen(lo);
+
+	if ((so != NULL && !strcmp(a, so)) || !strcmp(a, lo)) {
+		if (*i + 1U >= argc) {
+			return -1;
+		}
+		*val = argv[++*i];
+		return 1;
+	} else if (!strncmp(a, lo, lz) && a[lz] == '=') {
+		*val = a + lz + 1U;
+		return 1;
+	}
+	return 0;
+}
+
+static const char*
+parse_req(struct req_s *restrict r, const char *line, size_t llen)
+{
+/* turn LINE into a request, return an error message on failure */
+	const char *fzn = NULL;
+	const char *zn = NULL;
+	char **argv;
+	size_t argc = 1U;
+
+	if (UNLIKELY((r->buf = malloc(llen + 1U)) == NULL)) {
+		return "out of memory";
+	}
+	memcpy(r->buf, line, llen);
+	r->buf[llen] = '\0';
+	for (size_t i = 0U; i < llen; i++) {
+		argc += line[i] == '\t';
+	}
+	if (UNLIKELY((argv = calloc(argc, sizeof(*argv))) == NULL)) {
+		return "out of memory";
+	}
+	/* split at tabs, fields can hold anything but tabs */
+	argv[0U] = r->buf;
+	for (size_t i = 0U, j = 1U; i < llen; i++) {
+		if (r->buf[i] == '\t') {
+			r->buf[i] = '\0';
+			argv[j++] = r->buf + i + 1U;
+		}
+	}
+	/* input formats are a subset of ARGV, reuse its storage */
+	r->fmt = argv;
+
+	if (!strcmp(argv[0U], "conv")) {
+		r->tool = REQ_CONV;
+	} else if (!strcmp(argv[0U], "add")) {
+		r->tool = REQ_ADD;
+	} else {
+		return "unknown tool";
+	}
+	for (size_t i = 1U, optp = 1U; i < argc; i++) {
+		char *v;
+		int m;
+
+		if (!optp || *argv[i] != '-' ||
+		    (argv[i][1U] >= '0' && argv[i][1U] <= '9')) {
+			/* positional, negative durations included */
+			goto arg;
+		} else if (!strcmp(argv[i], "--")) {
+			optp = 0U;
+			continue;
+		} else if ((m = match_opt(argv, argc, &i,
+				   "-i", "--input-format", &v)) > 0) {
+			r->fmt[r->nfmt++] = v;
+		} else if (m < 0) {
+			goto noval;
+		} else if ((m = match_opt(argv, argc, &i,
+					  "-f", "--format", &v)) > 0) {
+			r->ofmt = v;
+		} else if (m < 0) {
+			goto noval;
+		} else if ((m = match_opt(argv, argc, &i,
+					  NULL, "--from-zone", &v)) > 0) {
+			fzn = v;
+		} else if (m < 0) {
+			goto noval;
+		} else if ((m = match_opt(argv, argc, &i,
+					  "-z", "--zone", &v)) > 0) {
+			zn = v;
+		} else if (m < 0) {
+			goto noval;
+		} else if ((m = match_opt(argv, argc, &i,
+					  NULL, "--from-locale", &v)) > 0) {
+			r->iloc = v;
+		} else if (m < 0) {
+			goto noval;
+		} else if ((m = match_opt(argv, argc, &i,
+					  NULL, "--locale", &v)) > 0) {
+			r->floc = v;
+		} else if (m < 0) {
+			goto noval;
+		} else {
+			return "unknown option";
+		}
+		continue;
+	arg:
+		if (r->tool != REQ_ADD) {
+			return "unexpected argument";
+		}
+		/* durations */
+		do {
+			if (dt_io_strpdtdur(&r->st, argv[i]) < 0) {
+				return "cannot parse duration";
+			}
+		} while (__strpdtdur_more_p(&r->st));
+	}
+	if (r->tool == REQ_ADD && !r->st.ndurs) {
+		return "no durations given";
+	}
+	/* zones come from the process-wide cache */
+	if (fzn != NULL && (r->fromz = dt_io_zone(fzn)) == NULL) {
+		return "unknown zone";
+	} else if (zn != NULL && (r->z = dt_io_zone(zn)) == NULL) {
+		return "unknown zone";
+	}
+	r->hackz = durs_only_d_p(r->st.durs, r->st.ndurs) ? NULL : r->fromz;
+	return NULL;
+
+noval:
+	return "option requires an argument";
+}
+
+static const struct req_s*
+find_req(const char *line, size_t llen, const char **err)
+{
+	struct req_s *r;
+
+	for (size_t i = 0U; i < countof(cache); i++) {
+		if (cache[i].llen == llen && cache[i].line != NULL &&
+		    !memcmp(cache[i].line, line, llen)) {
+			return cache + i;
+		}
+	}
+	/* not cached, evict the oldest one */
+	r = cache + cache_next++ % countof(cache);
+	free_req(r);
+	if ((*err = parse_req(r, line, llen)) != NULL) {
+		free_req(r);
+		return NULL;
+	} else if ((r->line = malloc(llen)) == NULL) {
+		free_req(r);
+		*err = "out of memory";
+		return NULL;
+	}
+	memcpy(r->line, line, llen);
+	r->llen = llen;
+	return r;
+}
+
+static bool
+xstreq(const char *s1, const char *s2)
+{
+	return s1 == s2 || (s1 != NULL && s2 != NULL && !strcmp(s1, s2));
+}
+
+static void
+use_locales(const struct req_s *r)
+{
+/* switch locales only if they differ from the previous request's */
+	static char *iloc;
+	static char *floc;
+
+	if (!xstreq(r->iloc, iloc)) {
+		setilocale(r->iloc);
+		free(iloc);
+		iloc = r->iloc ? strdup(r->iloc) : NULL;
+	}
+	if (!xstreq(r->floc, floc)) {
+		setflocale(r->floc);
+		free(floc);
+		floc = r->floc ? strdup(r->floc) : NULL;
+	}
+	return;
+}
+
+static void
+proc_line(const struct req_s *r, const char *line, size_t llen)
+{
+/* like dconv -E and dadd -E, exactly one line of output per line */
+	struct dt_dt_s d;
+	char *ep = NULL;
+
+	if (UNLIKELY(!llen)) {
+		goto empty;
+	}
+	d = dt_io_strpdt_ep(line, r->fmt, r->nfmt, &ep, r->fromz);
+	if (UNLIKELY(dt_unk_p(d))) {
+		goto empty;
+	} else if (ep && (unsigned char)*ep >= ' ') {
+		goto empty;
+	}
+	if (r->tool == REQ_ADD) {
+		for (size_t i = 0U; i < r->st.ndurs; i++) {
+			d = dt_dtadd(d, r->st.durs[i]);
+		}
+		if (UNLIKELY(dt_unk_p(d))) {
+			goto empty;
+		} else if (r->hackz == NULL && r->fromz != NULL) {
+			/* fixup zone */
+			d = dtz_forgetz(d, r->fromz);
+		}
+	}
+	dt_io_write(d, r->ofmt, r->z, '\n');
+	return;
+empty:
+	__io_write("\n", 1U, stdout);
+	return;
+}
+
+static void
+serve_conn(int cfd, int nfd)
+{
+/* handle requests on CFD until the client hangs up,
+ * responses go to stdout which is CFD for the time being */
+	const struct req_s *r = NULL;
+	const char *err = NULL;
+	bool inreqp = false;
+	char *line = NULL;
+	size_t llen = 0U;
+	FILE *in;
+
+	if ((in = fdopen(cfd, "r")) == NULL) {
+		close(cfd);
+		return;
+	}
+	dup2(cfd, STDOUT_FILENO);
+	clearerr(stdout);
+
+	for (ssize_t nrd; (nrd = getline(&line, &llen, in)) > 0;) {
+		char *lp = line;
+		size_t lz = nrd - (line[nrd - 1] == '\n');
+
+		lp[lz] = '\0';
+		if (!inreqp) {
+			/* request line */
+			if ((r = find_req(lp, lz, &err)) != NULL) {
+				use_locales(r);
+				fputs("ok\n", stdout);
+			} else {
+				fprintf(stdout, "error: %s\n", err);
+			}
+			inreqp = true;
+			continue;
+		} else if (lz == 1U && *lp == '.') {
+			/* end of request */
+			fflush(stdout);
+			inreqp = false;
+			continue;
+		} else if (*lp == '.') {
+			/* dot-stuffed */
+			lp++;
+			lz--;
+		}
+		if (r != NULL) {
+			proc_line(r, lp, lz);
+		}
+	}
+	free(line);
+	fflush(stdout);
+	/* let go of the connection entirely */
+	dup2(nfd, STDOUT_FILENO);
+	fclose(in);
+	return;
+}
+
+static void
+worker(int lfd)
+{
+	int nfd;
+
+	if ((nfd = open("/dev/null", O_WRONLY)) < 0) {
+		serror("Error: cannot open /dev/null");
+		return;
+	}
+	/* peers that go away must not take us with them */
+	signal(SIGPIPE, SIG_IGN);
+	/* no threads writing to this stream */
+	__io_setlocking_bycaller(stdout);
+
+	for (int cfd;;) {
+		if ((cfd = accept(lfd, NULL, NULL)) < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			serror("Error: cannot accept connections");
+			break;
+		}
+		serve_conn(cfd, nfd);
+	}
+	close(nfd);
+	return;
+}
+
+
+/* socket business */
+static int
+sock_addr(struct sockaddr_un *restrict sa, const char *path)
+{
+	const size_t pz = strlen(path);
+
+	if (pz >= sizeof(sa->sun_path)) {
+		error("Error: socket path `%s' too long", path);
+		return -1;
+	}
+	memset(sa, 0, sizeof(*sa));
+	sa->sun_family = AF_UNIX;
+	memcpy(sa->sun_path, path, pz + 1U);
+	return 0;
+}
+
+static int
+xcopy(int ofd, int ifd)
+{
+/* copy everything from IFD to OFD */
+	static char buf[65536U];
+
+	for (ssize_t nrd; (nrd = read(ifd, buf, sizeof(buf))) != 0;) {
+		if (nrd < 0 && errno == EINTR) {
+			continue;
+		} else if (nrd < 0) {
+			return -1;
+		}
+		for (ssize_t o = 0, nwr; o < nrd; o += nwr) {
+			if ((nwr = write(ofd, buf + o, nrd - o)) < 0) {
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+static int
+run_client(const char *path)
+{
+	struct sockaddr_un sa;
+	pid_t feed;
+	int sfd;
+	int rc = 0;
+
+	if (sock_addr(&sa, path) < 0) {
+		return 1;
+	} else if ((sfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+		serror("Error: cannot create socket");
+		return 1;
+	}
+	/* give freshly started servers a moment to come up */
+	for (size_t i = 0U;
+	     connect(sfd, (struct sockaddr*)&sa, sizeof(sa)) < 0; i++) {
+		static const struct timespec nap = {0, 20000000L};
+
+		if (i >= 100U || (errno != ENOENT && errno != ECONNREFUSED)) {
+			serror("Error: cannot connect to `%s'", path);
+			close(sfd);
+			return 1;
+		}
+		nanosleep(&nap, NULL);
+	}
+	/* feed requests from a separate process so the server never
+	 * blocks on us not reading its responses */
+	switch ((feed = fork())) {
+	case -1:
+		serror("Error: cannot fork");
+		close(sfd);
+		return 1;
+	case 0:
+		rc = xcopy(sfd, STDIN_FILENO);
+		shutdown(sfd, SHUT_WR);
+		_exit(rc < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+	default:
+		break;
+	}
+	if (xcopy(STDOUT_FILENO, sfd) < 0) {
+		serror("Error: cannot read responses");
+		rc = 1;
+	}
+	with (int st) {
+		while (waitpid(feed, &st, 0) != feed);
+		if (!WIFEXITED(st) || WEXITSTATUS(st)) {
+			rc = 1;
+		}
+	}
+	close(sfd);
+	return rc;
+}
+
+static volatile sig_atomic_t quitp;
+
+static void
+handle_quit(int UNUSED(sig))
+{
+	quitp = 1;
+	return;
+}
+
+static pid_t
+spawn_wrk(int lfd)
+{
+	pid_t pid;
+
+	switch ((pid = fork())) {
+	case 0:
+		signal(SIGINT, SIG_DFL);
+		signal(SIGTERM, SIG_DFL);
+		worker(lfd);
+		_exit(EXIT_FAILURE);
+	case -1:
+		serror("Error: cannot fork");
+	default:
+		break;
+	}
+	return pid;
+}
+
+
+#include "dserve.yucc"
+
+int
+main(int argc, char *argv[])
+{
+	yuck_t argi[1U];
+	struct sockaddr_un sa;
+	const char *path;
+	unsigned int njobs = 1U;
+	pid_t *pids = NULL;
+	int lfd = -1;
+	int rc = 0;
+
+	if (yuck_parse(argi, argc, argv)) {
+		rc = 1;
+		goto out;
+	} else if (argi->nargs != 1U) {
+		error("Error: exactly one SOCKET must be specified\n");
+		yuck_auto_help(argi);
+		rc = 1;
+		goto out;
+	}
+	path = argi->args[0U];
+
+	if (argi->client_flag) {
+		rc = run_client(path);
+		goto out;
+	}
+	if (argi->jobs_arg) {
+		char *on;
+		unsigned long j = strtoul(argi->jobs_arg, &on, 10);
+
+		if (*on || !j || j > 1024U) {
+			error("Error: invalid number of jobs `%s'",
+			      argi->jobs_arg);
+			rc = 1;
+			goto out;
+		}
+		njobs = (unsigned int)j;
+	}
+
+	if (sock_addr(&sa, path) < 0) {
+		rc = 1;
+		goto out;
+	} else if ((lfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+		serror("Error: cannot create socket");
+		rc = 1;
+		goto out;
+	}
+	/* get rid of stale sockets */
+	with (struct stat st) {
+		if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+			unlink(path);
+		}
+	}
+	if (bind(lfd, (struct sockaddr*)&sa, sizeof(sa)) < 0) {
+		serror("Error: cannot bind to `%s'", path);
+		rc = 1;
+		goto out;
+	} else if (listen(lfd, 64) < 0) {
+		serror("Error: cannot listen on `%s'", path);
+		rc = 1;
+		goto unl;
+	}
+
+	with (struct sigaction sact = {.sa_handler = handle_quit}) {
+		/* no SA_RESTART, wait() below is to notice */
+		sigemptyset(&sact.sa_mask);
+		sigaction(SIGINT, &sact, NULL);
+		sigaction(SIGTERM, &sact, NULL);
+	}
+	if ((pids = calloc(njobs, sizeof(*pids))) == NULL) {
+		serror("Error: cannot allocate worker table");
+		rc = 1;
+		goto unl;
+	}
+	for (unsigned int i = 0U; i < njobs; i++) {
+		if ((pids[i] = spawn_wrk(lfd)) < 0) {
+			rc = 1;
+			goto kill;
+		}
+	}
+	/* replace workers that die on us */
+	while (!quitp) {
+		pid_t pid = wait(NULL);
+
+		if (pid < 0 && errno == EINTR) {
+			continue;
+		} else if (pid < 0) {
+			break;
+		}
+		for (unsigned int i = 0U; i < njobs; i++) {
+			if (pids[i] == pid) {
+				pids[i] = spawn_wrk(lfd);
+				break;
+			}
+		}
+	}
+
+kill:
+	for (unsigned int i = 0U; i < njobs; i++) {
+		if (pids[i] > 0) {
+			kill(pids[i], SIGTERM);
+			while (waitpid(pids[i], NULL, 0) < 0 && errno == EINTR);
+		}
+	}
+unl:
+	unlink(path);
+out:
+	free(pids);
+	if (lfd >= 0) {
+		close(lfd);
+	}
+	yuck_free(argi);
+	return rc;
+}
+
+/* dserve.c ends here */
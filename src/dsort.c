@@ -41,9 +41,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
+#include <limits.h>
 #include <sys/time.h>
 #include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <time.h>
 
 #include "dt-core.h"
@@ -56,186 +61,657 @@ const char *prog = "dsort";
 struct prln_ctx_s {
 	struct grep_atom_soa_s *ndl;
 	zif_t fromz;
-	int outfd;
 };
 
 struct sort_ctx_s {
 	unsigned int revp:1U;
 	unsigned int unqp:1U;
+	/* number of key extraction processes */
+	unsigned int njobs;
+	/* memory budget for the in-core sort */
+	size_t bufsz;
 };
 
 
+/* in-core sort, all lines of all files are kept in one arena */
+struct arena_s {
+	char *buf;
+	size_t bsz;
+	size_t bno;
+	/* line offsets into buf, with one extra at the end */
+	size_t *off;
+	size_t noff;
+	size_t nln;
+};
+
+struct key_s {
+	uint64_t key;
+	/* nanoseconds below the resolution of KEY, to break ties */
+	unsigned int ns;
+	size_t lno;
+};
+
+/* dt_sortkey() counts 100ns ticks */
+#define NS_PER_TICK	(100U)
+/* room for NS, a power of 2 */
+#define NS_RANGE	(128U)
+
+/* sorted runs, spilled to temporary files when the arena outgrows
+ * its budget, and merged at the end */
+struct spill_s {
+	char **fns;
+	size_t nfns;
+};
+
+/* there's only ever one set of runs, signal handlers need to get at
+ * it to clean up */
+static struct spill_s spills;
+
+static void
+handle_spill_sig(int sig)
+{
+/* unlink the runs and die of SIG, just like sort(1) */
+	for (size_t i = 0U; i < spills.nfns; i++) {
+		unlink(spills.fns[i]);
+	}
+	signal(sig, SIG_DFL);
+	raise(sig);
+	return;
+}
+
 static void
-safe_write(int fd, const char *buf, size_t bsz)
+spill_sigs(void (*hdl)(int))
 {
-	size_t tot = 0U;
-	for (ssize_t nwr;
-	     tot < bsz && (nwr = write(fd, buf + tot, bsz - tot)) >= 0;
-	     tot += nwr);
+	static const int sigs[] = {SIGHUP, SIGINT, SIGTERM};
+
+	for (size_t i = 0U; i < countof(sigs); i++) {
+		struct sigaction sact = {.sa_handler = hdl};
+
+		sigemptyset(&sact.sa_mask);
+		sigaction(sigs[i], &sact, NULL);
+	}
 	return;
 }
 
 static void
-proc_line(struct prln_ctx_s ctx, char *line, size_t llen)
+spill_block(bool blockp)
+{
+/* keep the signal handlers off SPILLS while we change it */
+	sigset_t ss;
+
+	sigemptyset(&ss);
+	sigaddset(&ss, SIGHUP);
+	sigaddset(&ss, SIGINT);
+	sigaddset(&ss, SIGTERM);
+	sigprocmask(blockp ? SIG_BLOCK : SIG_UNBLOCK, &ss, NULL);
+	return;
+}
+
+static uint64_t
+line_key(
+	struct prln_ctx_s ctx, const char *line, size_t llen,
+	unsigned int *restrict ns)
 {
+/* dt_sortkey() puts undated lines first, then times without dates;
+ * dates without times key like midnight, the tick count is always
+ * less than 10^7 so bumping it for everything else sorts dates before
+ * any date/time on the same day,
+ * the nanoseconds it can't resolve go to NS */
 	struct dt_dt_s d;
+	char *sp, *tp;
+
+	d = dt_io_find_strpdt2(line, llen, ctx.ndl, &sp, &tp, ctx.fromz);
+	if (dt_unk_p(d)) {
+		*ns = 0U;
+		return 0U;
+	} else if (d.typ == DT_NSEXY) {
+		const dt_nsexy_t r = d.nsexy % (dt_nsexy_t)NS_PER_TICK;
+		*ns = (unsigned int)(r < 0 ? r + (dt_nsexy_t)NS_PER_TICK : r);
+	} else if (dt_sandwich_p(d) || dt_sandwich_only_t_p(d)) {
+		*ns = d.t.hms.ns % NS_PER_TICK;
+	} else {
+		*ns = 0U;
+	}
+	return dt_sortkey(d) + !dt_sandwich_only_d_p(d);
+}
 
-	do {
-		char buf[64U];
-		char *sp, *tp;
-		char *bp = buf;
-		const char *const ep = buf + sizeof(buf);
-
-		/* find first occurrence then */
-		d = dt_io_find_strpdt2(
-			line, llen, ctx.ndl, &sp, &tp, ctx.fromz);
-		/* print line, first thing */
-		safe_write(ctx.outfd, line, llen);
-
-		/* extend by separator */
-		*bp++ = '\001';
-		/* check if line matches */
-		if (!dt_unk_p(d)) {
-			/* match! */
-			if (!dt_sandwich_only_t_p(d)) {
-				bp += dt_strfdt(bp, ep - bp, "%F", d);
-			}
-			*bp++ = '\001';
-			if (!dt_sandwich_only_d_p(d)) {
-				bp += dt_strfdt(bp, ep - bp, "%T", d);
-			}
-		} else {
-			/* just two empty fields then, innit? */
-			*bp++ = '\001';
-		}
-		/* finalise the line and print */
-		*bp++ = '\n';
-		safe_write(ctx.outfd, buf, bp - buf);
-	} while (0);
+static int
+arena_add(struct arena_s *restrict a, const char *line, size_t llen)
+{
+	if (UNLIKELY(a->bno + llen + 1U > a->bsz)) {
+		size_t nsz = a->bsz ?: 65536U;
+		char *nu;
+
+		while ((nsz *= 2U) < a->bno + llen + 1U);
+		if (UNLIKELY((nu = realloc(a->buf, nsz)) == NULL)) {
+			return -1;
+		}
+		a->buf = nu;
+		a->bsz = nsz;
+	}
+	if (UNLIKELY(a->nln + 1U >= a->noff)) {
+		size_t nsz = a->noff ? a->noff * 2U : 16384U;
+		size_t *nu;
+
+		if (UNLIKELY((nu = realloc(a->off, nsz * sizeof(*nu))) == NULL)) {
+			return -1;
+		}
+		a->off = nu;
+		a->noff = nsz;
+	}
+	/* keep the \0 for the date/time scanner */
+	memcpy(a->buf + a->bno, line, llen + 1U);
+	a->off[a->nln++] = a->bno;
+	a->bno += llen + 1U;
+	a->off[a->nln] = a->bno;
+	return 0;
+}
+
+static inline size_t
+arena_size(const struct arena_s *a)
+{
+/* line offsets and two keys per line on top of the lines */
+	return a->bno + a->nln * (sizeof(*a->off) + 2U * sizeof(struct key_s));
+}
+
+static void
+key_range(
+	struct prln_ctx_s ctx, const struct arena_s *a, struct key_s *restrict k,
+	size_t beg, size_t end, bool revp)
+{
+/* complementing keys gives descending order without losing stability */
+	const uint64_t msk = revp ? UINT64_MAX : 0U;
+	const unsigned int nsmsk = revp ? NS_RANGE - 1U : 0U;
+
+	for (size_t i = beg; i < end; i++) {
+		const size_t llen = a->off[i + 1U] - a->off[i] - 1U;
+		unsigned int ns;
+
+		k[i].key = line_key(ctx, a->buf + a->off[i], llen, &ns) ^ msk;
+		k[i].ns = ns ^ nsmsk;
+		k[i].lno = i;
+	}
 	return;
 }
 
 static int
-proc_file(struct prln_ctx_s prln, const char *fn)
+key_lines(
+	struct prln_ctx_s ctx, const struct arena_s *a, struct key_s *restrict k,
+	struct sort_ctx_s sopt)
+{
+/* scanning for date/times is the expensive bit, so fork off workers
+ * for all but the first slice, K is shared with them */
+#define MIN_SLICE	(65536U)
+	const size_t n = a->nln;
+	size_t nj = n / MIN_SLICE;
+	pid_t *pids;
+	int rc = 0;
+
+	if (nj > sopt.njobs) {
+		nj = sopt.njobs;
+	}
+	if (nj <= 1U || (pids = calloc(nj, sizeof(*pids))) == NULL) {
+		key_range(ctx, a, k, 0U, n, sopt.revp);
+		return 0;
+	}
+	/* flush now lest the workers inherit pending output */
+	fflush(stdout);
+	for (size_t j = 1U; j < nj; j++) {
+		const size_t beg = n * j / nj;
+		const size_t end = n * (j + 1U) / nj;
+
+		switch ((pids[j] = fork())) {
+		case -1:
+			/* do it ourselves then */
+			key_range(ctx, a, k, beg, end, sopt.revp);
+			break;
+		case 0:
+			/* the runs are the parent's to clean up */
+			spill_sigs(SIG_DFL);
+			dt_io_stats_slot(j);
+			key_range(ctx, a, k, beg, end, sopt.revp);
+			dt_io_stats_sync();
+			_exit(EXIT_SUCCESS);
+		default:
+			break;
+		}
+	}
+	key_range(ctx, a, k, 0U, n / nj, sopt.revp);
+	for (size_t j = 1U; j < nj; j++) {
+		int st;
+
+		if (pids[j] <= 0) {
+			continue;
+		}
+		while (waitpid(pids[j], &st, 0) != pids[j]);
+		if (!WIFEXITED(st) || WEXITSTATUS(st)) {
+			rc = -1;
+		}
+	}
+	free(pids);
+#undef MIN_SLICE
+	return rc;
+}
+
+static struct key_s*
+sort_keys(struct key_s *restrict k, struct key_s *restrict tmp, size_t n)
+{
+/* LSD radix sort, stable, passes where all keys share the digit are
+ * skipped, returns whichever of K and TMP holds the result,
+ * the NS tie breakers are the least significant digit */
+#define RDX_BITS	(11U)
+#define RDX_NBKT	(1U << RDX_BITS)
+#define RDX_NDIG	((64U + RDX_BITS - 1U) / RDX_BITS)
+	static size_t cnt[RDX_NDIG][RDX_NBKT];
+	static size_t nscnt[NS_RANGE];
+
+	memset(cnt, 0, sizeof(cnt));
+	memset(nscnt, 0, sizeof(nscnt));
+	for (size_t i = 0U; i < n; i++) {
+		uint64_t x = k[i].key;
+
+		for (size_t d = 0U; d < RDX_NDIG; d++, x >>= RDX_BITS) {
+			cnt[d][x & (RDX_NBKT - 1U)]++;
+		}
+		nscnt[k[i].ns]++;
+	}
+	if (nscnt[k[0U].ns] < n) {
+		size_t sum = 0U;
+
+		for (size_t b = 0U; b < NS_RANGE; b++) {
+			const size_t c = nscnt[b];
+			nscnt[b] = sum;
+			sum += c;
+		}
+		for (size_t i = 0U; i < n; i++) {
+			tmp[nscnt[k[i].ns]++] = k[i];
+		}
+		with (struct key_s *x = k) {
+			k = tmp;
+			tmp = x;
+		}
+	}
+	for (size_t d = 0U; d < RDX_NDIG; d++) {
+		const unsigned int sh = d * RDX_BITS;
+		size_t sum = 0U;
+
+		if (cnt[d][(k[0U].key >> sh) & (RDX_NBKT - 1U)] == n) {
+			/* nothing to do */
+			continue;
+		}
+		/* counts to offsets */
+		for (size_t b = 0U; b < RDX_NBKT; b++) {
+			const size_t c = cnt[d][b];
+			cnt[d][b] = sum;
+			sum += c;
+		}
+		for (size_t i = 0U; i < n; i++) {
+			const size_t b = (k[i].key >> sh) & (RDX_NBKT - 1U);
+			tmp[cnt[d][b]++] = k[i];
+		}
+		with (struct key_s *x = k) {
+			k = tmp;
+			tmp = x;
+		}
+	}
+#undef RDX_BITS
+#undef RDX_NBKT
+#undef RDX_NDIG
+	return k;
+}
+
+static int
+sort_arena(
+	struct prln_ctx_s ctx, struct sort_ctx_s sopt,
+	struct arena_s *restrict a, FILE *out)
+{
+	struct key_s *k, *tmp, *res;
+	size_t ksz;
+	int rc = 0;
+
+	if (a->nln == 0U) {
+		return 0;
+	}
+	/* keys go into shared memory so workers can fill them in */
+	ksz = a->nln * sizeof(*k);
+	k = mmap(NULL, ksz, PROT_READ | PROT_WRITE,
+		 MAP_SHARED | MAP_ANON, -1, 0);
+	if (UNLIKELY(k == MAP_FAILED)) {
+		serror("Error: cannot allocate sort keys");
+		return -1;
+	} else if (UNLIKELY((tmp = malloc(ksz)) == NULL)) {
+		serror("Error: cannot allocate sort keys");
+		munmap(k, ksz);
+		return -1;
+	}
+	if (key_lines(ctx, a, k, sopt) < 0) {
+		error("Error: key extraction failed");
+		rc = -1;
+		goto unmap;
+	}
+	res = sort_keys(k, tmp, a->nln);
+
+	for (size_t i = 0U; i < a->nln; i++) {
+		const size_t lno = res[i].lno;
+		char *line = a->buf + a->off[lno];
+		const size_t llen = a->off[lno + 1U] - a->off[lno];
+
+		if (sopt.unqp && i && res[i].key == res[i - 1U].key &&
+		    res[i].ns == res[i - 1U].ns) {
+			continue;
+		}
+		line[llen - 1U] = '\n';
+		__io_write(line, llen, out);
+	}
+unmap:
+	free(tmp);
+	munmap(k, ksz);
+	return rc;
+}
+
+static int
+spill_arena(
+	struct prln_ctx_s ctx, struct sort_ctx_s sopt,
+	struct arena_s *restrict a, struct spill_s *restrict sp)
+{
+/* sort A into a new temporary file and empty it */
+	static const char tmpl[] = "/dsort.XXXXXX";
+	const char *tmpd = getenv("TMPDIR") ?: "/tmp";
+	char *fn;
+	FILE *f;
+	int fd;
+	int rc;
+
+	if (UNLIKELY(sp->nfns == 0U)) {
+		/* first run, don't leave it lying around when killed */
+		spill_sigs(handle_spill_sig);
+	}
+	if (UNLIKELY((fn = malloc(strlen(tmpd) + sizeof(tmpl))) == NULL)) {
+		serror("Error: cannot create temporary file");
+		return -1;
+	}
+	with (size_t z = strlen(tmpd)) {
+		memcpy(fn, tmpd, z);
+		memcpy(fn + z, tmpl, sizeof(tmpl));
+	}
+	spill_block(true);
+	if (UNLIKELY((sp->nfns % 16U) == 0U)) {
+		const size_t nsz = sp->nfns + 16U;
+		char **nu = realloc(sp->fns, nsz * sizeof(*nu));
+
+		if (UNLIKELY(nu == NULL)) {
+			spill_block(false);
+			serror("Error: cannot keep track of sorted runs");
+			free(fn);
+			return -1;
+		}
+		sp->fns = nu;
+	}
+	if (UNLIKELY((fd = mkstemp(fn)) < 0)) {
+		spill_block(false);
+		serror("Error: cannot create temporary file in `%s'", tmpd);
+		free(fn);
+		return -1;
+	}
+	/* from now on it's ours to clean up */
+	sp->fns[sp->nfns++] = fn;
+	spill_block(false);
+
+	if (UNLIKELY((f = fdopen(fd, "w")) == NULL)) {
+		serror("Error: cannot write to `%s'", fn);
+		close(fd);
+		return -1;
+	}
+
+	rc = sort_arena(ctx, sopt, a, f);
+	if (UNLIKELY(fclose(f) == EOF) && rc == 0) {
+		serror("Error: cannot write to `%s'", fn);
+		rc = -1;
+	}
+	a->bno = 0U;
+	a->nln = 0U;
+	return rc;
+}
+
+static int
+proc_file(
+	struct prln_ctx_s ctx, struct sort_ctx_s sopt,
+	struct arena_s *restrict a, struct spill_s *restrict sp,
+	const char *fn)
 {
-	size_t lno = 0;
 	void *pctx;
+	pid_t dec;
 	int fd;
+	int rc = 0;
 
-	if (fn == NULL) {
-		/* stdin then innit */
-		fd = STDIN_FILENO;
-	} else if ((fd = open(fn, O_RDONLY)) < 0) {
-		serror("Error: cannot open file `%s'", fn);
+	if ((fd = dt_io_open(fn, &dec)) < 0) {
 		return -1;
 	}
 
 	/* using the prchunk reader now */
 	if ((pctx = init_prchunk(fd)) == NULL) {
 		serror("Error: cannot read from `%s'", fn ?: "<stdin>");
+		dt_io_close(fd, dec);
 		return -1;
 	}
 
-	while (prchunk_fill(pctx) >= 0) {
-		for (char *line; prchunk_haslinep(pctx); lno++) {
+	while (rc == 0 && prchunk_fill(pctx) >= 0) {
+		for (char *line; prchunk_haslinep(pctx);) {
 			size_t llen = prchunk_getline(pctx, &line);
 
-			proc_line(prln, line, llen);
+			if (UNLIKELY(arena_add(a, line, llen) < 0)) {
+				error("Error: cannot store lines of `%s'",
+				      fn ?: "<stdin>");
+				rc = -1;
+				break;
+			} else if (UNLIKELY(arena_size(a) > sopt.bufsz) &&
+				   spill_arena(ctx, sopt, a, sp) < 0) {
+				rc = -1;
+				break;
+			}
 		}
 	}
 	/* get rid of resources */
 	free_prchunk(pctx);
-	close(fd);
-	return 0;
+	if (dt_io_close(fd, dec) < 0) {
+		rc = -1;
+	}
+	return rc;
 }
 
-
-/* helper children, sort(1) and cut(1) */
-static pid_t
-spawn_sort(int *restrict infd, const int outfd, struct sort_ctx_s sopt)
+static int
+proc_merge(
+	struct prln_ctx_s ctx, struct sort_ctx_s sopt,
+	char *const fns[], size_t nfn);
+
+static int
+proc_sort(
+	struct prln_ctx_s ctx, struct sort_ctx_s sopt,
+	char *const fns[], size_t nfn)
 {
-	static char *cmdline[16U] = {"sort", "-t", "-k2"};
-	pid_t sortp;
-	/* to snarf off traffic from the child */
-	int intfd[2];
+	struct arena_s a = {NULL};
+	struct spill_s *sp = &spills;
+	int rc = 0;
 
-	if (pipe(intfd) < 0) {
-		serror("pipe setup to/from sort failed");
-		return -1;
+	for (size_t i = 0U; i < nfn; i++) {
+		if (proc_file(ctx, sopt, &a, sp, fns[i]) < 0) {
+			rc = 1;
+		}
+	}
+	if (sp->nfns == 0U) {
+		/* all in core, yay */
+		if (sort_arena(ctx, sopt, &a, stdout) < 0) {
+			rc = 1;
+		}
+	} else if (a.nln && spill_arena(ctx, sopt, &a, sp) < 0) {
+		rc = 1;
+	} else {
+		/* runs keep their input order, so merging is stable too */
+		free(a.buf);
+		a.buf = NULL;
+		if (proc_merge(ctx, sopt, sp->fns, sp->nfns)) {
+			rc = 1;
+		}
 	}
+	spill_block(true);
+	for (size_t i = 0U; i < sp->nfns; i++) {
+		unlink(sp->fns[i]);
+		free(sp->fns[i]);
+	}
+	free(sp->fns);
+	sp->fns = NULL;
+	sp->nfns = 0U;
+	spill_block(false);
+	free(a.buf);
+	free(a.off);
+	return rc;
+}
 
-	switch ((sortp = vfork())) {
-	case -1:
-		/* i am an error */
-		serror("vfork for sort failed");
-		return -1;
+
+/* k-way merge of pre-sorted files */
+struct mrg_cur_s {
+	void *pctx;
+	int fd;
+	pid_t dec;
+	/* current line */
+	char *line;
+	size_t llen;
+	/* sort key of current line, and its tie breaker */
+	uint64_t key;
+	unsigned int ns;
+};
 
-	default:
-		/* i am the parent */
-		close(intfd[0]);
-		*infd = intfd[1];
-		/* close outfd here already */
-		close(outfd);
-		return sortp;
+static int
+mrg_next(struct prln_ctx_s ctx, struct mrg_cur_s *restrict c)
+{
+/* advance cursor C to its next line, return -1 at EOF */
+	while (!prchunk_haslinep(c->pctx)) {
+		if (prchunk_fill(c->pctx) < 0) {
+			return -1;
+		}
+	}
+	c->llen = prchunk_getline(c->pctx, &c->line);
+	c->key = line_key(ctx, c->line, c->llen, &c->ns);
+	return 0;
+}
 
-	case 0:;
-		char **cp = cmdline + 3U;
+static inline bool
+mrg_less(const struct mrg_cur_s *c, size_t i, size_t j, bool revp)
+{
+/* order by key and nanoseconds, then by file for stability */
+	if (c[i].key != c[j].key) {
+		return (c[i].key < c[j].key) ^ revp;
+	} else if (c[i].ns != c[j].ns) {
+		return (c[i].ns < c[j].ns) ^ revp;
+	}
+	return i < j;
+}
 
-		/* i am the child */
-		if (sopt.revp) {
-			*cp++ = "-r";
+static void
+mrg_sift(const struct mrg_cur_s *c, size_t *restrict h, size_t nh, bool revp)
+{
+/* sift the top of heap H down */
+	for (size_t i = 0U, k; (k = 2U * i + 1U) < nh; i = k) {
+		if (k + 1U < nh && mrg_less(c, h[k + 1U], h[k], revp)) {
+			k++;
 		}
-		if (sopt.unqp) {
-			*cp++ = "-u";
+		if (!mrg_less(c, h[k], h[i], revp)) {
+			break;
+		}
+		with (size_t tmp = h[i]) {
+			h[i] = h[k];
+			h[k] = tmp;
 		}
-		*cp++ = NULL;
-
-		/* stdout -> outfd */
-		dup2(outfd, STDOUT_FILENO);
-		/* *infd -> stdin */
-		dup2(intfd[0], STDIN_FILENO);
-		close(intfd[1]);
-
-		execvp("sort", cmdline);
-		serror("execvp(sort) failed");
-		_exit(EXIT_FAILURE);
 	}
+	return;
 }
 
-static pid_t
-spawn_cut(int *restrict infd)
+static int
+proc_merge(
+	struct prln_ctx_s ctx, struct sort_ctx_s sopt,
+	char *const fns[], size_t nfn)
 {
-	static char *const cmdline[] = {"cut", "-d", "-f1", NULL};
-	pid_t cutp;
-	/* to snarf off traffic from the child */
-	int intfd[2];
+	struct mrg_cur_s *c;
+	size_t *h;
+	size_t nh = 0U;
+	uint64_t last = 0U;
+	unsigned int lastns = 0U;
+	bool lastp = false;
+	int rc = 0;
 
-	if (pipe(intfd) < 0) {
-		serror("pipe setup to/from cut failed");
+	if (UNLIKELY((c = calloc(nfn, sizeof(*c))) == NULL)) {
+		error("Error: cannot allocate merge cursors");
 		return -1;
-	}
-
-	switch ((cutp = vfork())) {
-	case -1:
-		/* i am an error */
-		serror("vfork for cut failed");
+	} else if (UNLIKELY((h = calloc(nfn, sizeof(*h))) == NULL)) {
+		error("Error: cannot allocate merge heap");
+		free(c);
 		return -1;
-
-	default:;
-		/* i am the parent */
-		close(intfd[0]);
-		*infd = intfd[1];
-		return cutp;
-
-	case 0:;
-		/* i am the child */
-		dup2(intfd[0], STDIN_FILENO);
-		close(intfd[1]);
-
-		execvp("cut", cmdline);
-		serror("execvp(cut) failed");
-		_exit(EXIT_FAILURE);
 	}
+	with (struct rlimit r) {
+		/* we'll hold all files open at once, so try and raise
+		 * the descriptor limit if need be, decompressors and
+		 * stdio want some slack */
+		if (getrlimit(RLIMIT_NOFILE, &r) < 0) {
+			break;
+		} else if (r.rlim_cur >= nfn + 16U) {
+			break;
+		}
+		r.rlim_cur = nfn + 16U < r.rlim_max ? nfn + 16U : r.rlim_max;
+		(void)setrlimit(RLIMIT_NOFILE, &r);
+	}
+	for (size_t i = 0U; i < nfn; i++) {
+		if ((c[i].fd = dt_io_open(fns[i], &c[i].dec)) < 0) {
+			rc = 1;
+			continue;
+		} else if ((c[i].pctx = init_prchunk_r(c[i].fd)) == NULL) {
+			serror("Error: cannot read from `%s'",
+			       fns[i] ?: "<stdin>");
+			dt_io_close(c[i].fd, c[i].dec);
+			c[i].fd = -1;
+			rc = 1;
+			continue;
+		} else if (mrg_next(ctx, c + i) < 0) {
+			/* empty file */
+			continue;
+		}
+		/* push and sift up */
+		with (size_t k = nh++) {
+			for (; k > 0U &&
+				     mrg_less(c, i, h[(k - 1U) / 2U], sopt.revp);
+			     k = (k - 1U) / 2U) {
+				h[k] = h[(k - 1U) / 2U];
+			}
+			h[k] = i;
+		}
+	}
+	while (nh > 0U) {
+		struct mrg_cur_s *top = c + h[0U];
+
+		if (!sopt.unqp || !lastp ||
+		    top->key != last || top->ns != lastns) {
+			top->line[top->llen] = '\n';
+			__io_write(top->line, top->llen + 1U, stdout);
+			last = top->key;
+			lastns = top->ns;
+			lastp = true;
+		}
+		if (mrg_next(ctx, top) < 0) {
+			/* exhausted, replace by the last one */
+			h[0U] = h[--nh];
+		}
+		mrg_sift(c, h, nh, sopt.revp);
+	}
+	for (size_t i = 0U; i < nfn; i++) {
+		if (c[i].pctx != NULL) {
+			free_prchunk_r(c[i].pctx);
+		}
+		if (c[i].fd >= 0 && dt_io_close(c[i].fd, c[i].dec) < 0) {
+			rc = 1;
+		}
+	}
+	free(h);
+	free(c);
+	return rc;
 }
 
 
@@ -283,6 +759,66 @@ main(int argc, char *argv[])
 	if (argi->unique_flag) {
 		sopt.unqp = 1U;
 	}
+	if (argi->jobs_arg) {
+		char *on;
+		unsigned long j = strtoul(argi->jobs_arg, &on, 10);
+
+		if (*on || !j) {
+			error("Error: invalid number of jobs `%s'",
+			      argi->jobs_arg);
+			rc = 1;
+			goto out;
+		}
+		sopt.njobs = j < UINT_MAX ? (unsigned int)j : UINT_MAX;
+	} else {
+		long j = sysconf(_SC_NPROCESSORS_ONLN);
+		sopt.njobs = j > 0 ? (unsigned int)j : 1U;
+	}
+	if (argi->buffer_size_arg) {
+		char *on;
+		unsigned long long z = strtoull(argi->buffer_size_arg, &on, 10);
+
+		switch (*on) {
+		case 'G':
+		case 'g':
+			z *= 1024U;
+			/*@fallthrough@*/
+		case 'M':
+		case 'm':
+			z *= 1024U;
+			/*@fallthrough@*/
+		case 'K':
+		case 'k':
+			z *= 1024U;
+			on++;
+			break;
+		default:
+			break;
+		}
+		if (*on || !z) {
+			error("Error: invalid buffer size `%s'",
+			      argi->buffer_size_arg);
+			rc = 1;
+			goto out;
+		}
+		sopt.bufsz = z < SIZE_MAX ? (size_t)z : SIZE_MAX;
+	} else {
+		long np = sysconf(_SC_PHYS_PAGES);
+		long pz = sysconf(_SC_PAGESIZE);
+
+		sopt.bufsz = np > 0 && pz > 0
+			? (size_t)np / 4U * (size_t)pz : SIZE_MAX;
+	}
+	if (argi->stats_arg) {
+		const char *how = argi->stats_arg != YUCK_OPTARG_NONE
+			? argi->stats_arg : NULL;
+
+		/* one slot per key extraction process */
+		if (dt_io_stats_init(how, fmt, nfmt, sopt.njobs) < 0) {
+			rc = 1;
+			goto out;
+		}
+	}
 
 	{
 		/* process all files */
@@ -293,7 +829,7 @@ main(int argc, char *argv[])
 			.ndl = &ndlsoa,
 			.fromz = fromz,
 		};
-		pid_t cutp, sortp;
+		const size_t nfn = argi->nargs ?: 1U;
 
 		/* lest we overflow the stack */
 		if (nfmt >= nneedle) {
@@ -304,42 +840,15 @@ main(int argc, char *argv[])
 		/* and now build the needles */
 		ndlsoa = build_needle(needle, nneedle, fmt, nfmt);
 
-		/* spawn children */
-		with (int ifd, ofd) {
-			if ((cutp = spawn_cut(&ifd)) < 0) {
-				goto ndl_free;
-			}
-			if ((sortp = spawn_sort(&ofd, ifd, sopt)) < 0) {
-				goto ndl_free;
-			}
-			prln.outfd = ofd;
-		}
-
-		for (size_t i = 0U; i < argi->nargs || i == 0U; i++) {
-			if (proc_file(prln, argi->args[i]) < 0) {
+		if (argi->merge_flag) {
+			/* FILEs are sorted already */
+			if (proc_merge(prln, sopt, argi->args, nfn)) {
 				rc = 1;
 			}
+		} else if (proc_sort(prln, sopt, argi->args, nfn)) {
+			rc = 1;
 		}
 
-		/* indicate we're no longer writing to the sort helper */
-		close(prln.outfd);
-
-		/* wait for sort first */
-		with (int st) {
-			while (waitpid(sortp, &st, 0) != sortp);
-			if (WIFEXITED(st) && WEXITSTATUS(st)) {
-				rc = rc ?: WEXITSTATUS(st);
-			}
-		}
-		/* wait for cut then */
-		with (int st) {
-			while (waitpid(cutp, &st, 0) != cutp);
-			if (WIFEXITED(st) && WEXITSTATUS(st)) {
-				rc = rc ?: WEXITSTATUS(st);
-			}
-		}
-
-	ndl_free:
 		if (needle != __nstk) {
 			free(needle);
 		}
@@ -351,6 +860,7 @@ main(int argc, char *argv[])
 	}
 
 out:
+	dt_io_stats_fini();
 	yuck_free(argi);
 	return rc;
 }
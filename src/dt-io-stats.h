@@ -0,0 +1,138 @@
+/*** dt-io-stats.h -- runtime statistics for the line tools
+ *
+ * Copyright (C) 2011-2019 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of dateutils.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_dt_io_stats_h_
+#define INCLUDED_dt_io_stats_h_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <time.h>
+#include "nifty.h"
+
+/* runtime statistics, stages are timed separately */
+typedef enum {
+	DT_IO_STG_READ,
+	DT_IO_STG_SCAN,
+	DT_IO_STG_PARSE,
+	DT_IO_STG_CONV,
+	DT_IO_STG_FMT,
+	DT_IO_STG_WRITE,
+	DT_IO_NSTG,
+} dt_io_stg_t;
+
+struct dt_io_stats_s {
+	/* bytes and lines read, bytes written */
+	size_t nrd;
+	size_t nln;
+	size_t nwr;
+	/* date/times found or parsed, and failed attempts */
+	size_t nok;
+	size_t nfail;
+	/* zone cache hits and misses, see dt_io_stats_sync() */
+	size_t nzhit;
+	size_t nzmiss;
+	/* ticks spent per stage */
+	uint64_t tck[DT_IO_NSTG];
+	/* successes per input format, the last one counts defaults */
+	size_t nfmt[];
+};
+
+/* statistics, non-NULL iff collection is switched on */
+extern struct dt_io_stats_s *dt_io_stats;
+
+/**
+ * Switch on statistics collection for the input formats FMT,
+ * output at dt_io_stats_fini() will be in format HOW, "kv" or "json".
+ * NSLOT is the number of worker processes plus one. */
+extern int
+dt_io_stats_init(const char *how, char *const *fmt, size_t nfmt, size_t nslot);
+
+/**
+ * For worker processes, use statistics slot SLOT from now on. */
+extern void dt_io_stats_slot(size_t slot);
+
+/**
+ * For worker processes, deposit process-local counters before exiting. */
+extern void dt_io_stats_sync(void);
+
+/**
+ * Print statistics to stderr and switch collection off again. */
+extern void dt_io_stats_fini(void);
+
+/**
+ * Count a successful parse with format FMT. */
+extern void dt_io_stats_fmt(const char *fmt);
+
+
+/* statistics timer, cheap ticks to be calibrated at the end */
+static inline __attribute__((unused)) uint64_t
+__stats_now(void)
+{
+#if defined __x86_64__ || defined __i386__
+	return __builtin_ia32_rdtsc();
+#else  /* !__x86_64__ && !__i386__ */
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif	/* __x86_64__ || __i386__ */
+}
+
+static inline __attribute__((unused)) uint64_t
+dt_io_stats_tick(void)
+{
+	if (LIKELY(dt_io_stats == NULL)) {
+		return 0U;
+	}
+	return __stats_now();
+}
+
+static inline __attribute__((unused)) void
+dt_io_stats_lap(dt_io_stg_t stg, uint64_t *restrict t)
+{
+/* attribute time since *T to stage STG, restart the clock */
+	if (LIKELY(dt_io_stats == NULL)) {
+		return;
+	}
+	with (uint64_t now = __stats_now()) {
+		dt_io_stats->tck[stg] += now - *t;
+		*t = now;
+	}
+	return;
+}
+
+#endif	/* INCLUDED_dt_io_stats_h_ */
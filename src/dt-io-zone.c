@@ -165,6 +165,8 @@ Set TZMAP_DIR environment variable to where " TZMAP_SUF " files reside", tzmfn);
 void
 dt_io_clear_zones(void)
 {
+	/* zone caches go away now, hand over their counters */
+	dt_io_stats_sync();
 	if (tzmaps->data != NULL) {
 		for (acons_t c; (c = alist_next(tzmaps)).val;) {
 			tzm_close(c.val);
@@ -180,4 +182,20 @@ dt_io_clear_zones(void)
 	return;
 }
 
+void
+dt_io_zone_stats(size_t *restrict nhit, size_t *restrict nmiss)
+{
+	*nhit = *nmiss = 0U;
+	if (zones->data != NULL) {
+		for (acons_t c; (c = alist_next(zones)).val;) {
+			size_t h, m;
+
+			zif_cache_stats(c.val, &h, &m);
+			*nhit += h;
+			*nmiss += m;
+		}
+	}
+	return;
+}
+
 /* dt-io-zone.c ends here */
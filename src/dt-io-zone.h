@@ -43,4 +43,7 @@ extern zif_t dt_io_zone(const char *spec);
 
 extern void dt_io_clear_zones(void);
 
+/* sum up zone cache hits and misses of all zones in use */
+extern void dt_io_zone_stats(size_t *restrict nhit, size_t *restrict nmiss);
+
 #endif	/* INCLUDED_dt_io_zone_h_ */
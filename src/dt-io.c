@@ -13,6 +13,12 @@
 #include <strings.h>
 #include <stdarg.h>
 #include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <time.h>
 #include "dt-core.h"
 #include "dt-core-tz-glue.h"
 #include "date-core-private.h"
@@ -25,6 +31,7 @@
 #include "nifty.h"
 #include "dt-io.h"
 #include "alist.h"
+#include "bizcal.h"
 
 #if defined __INTEL_COMPILER
 /* we MUST return a char* */
@@ -68,6 +75,241 @@ serror(const char *fmt, ...)
 	return;
 }
 
+
+/* runtime statistics */
+struct dt_io_stats_s *dt_io_stats;
+
+static struct {
+	/* all slots, slot 0 is the main process */
+	struct dt_io_stats_s *slots;
+	size_t nslot;
+	size_t slotz;
+	/* input formats, for per-format counts */
+	char *const *fmt;
+	size_t nfmt;
+	/* zone cache counters at the time of dt_io_stats_slot() */
+	size_t nzhit;
+	size_t nzmiss;
+	/* calibration points */
+	uint64_t tck0;
+	struct timespec ts0;
+	bool jsonp;
+} stats;
+
+static inline struct dt_io_stats_s*
+__stats_slot(size_t i)
+{
+	return (void*)((char*)stats.slots + i * stats.slotz);
+}
+
+static void
+__stats_res(struct dt_dt_s d, char *const *fmt, size_t fi)
+{
+/* count result D, obtained with FMT[FI] */
+	if (dt_unk_p(d)) {
+		dt_io_stats->nfail++;
+		return;
+	}
+	dt_io_stats->nok++;
+	if (fmt == stats.fmt && fi < stats.nfmt) {
+		dt_io_stats->nfmt[fi]++;
+	} else {
+		/* not one of ours, count as default */
+		dt_io_stats->nfmt[stats.nfmt]++;
+	}
+	return;
+}
+
+static struct dt_dt_s
+__strpdt_ep(
+	const char *str, char *const *fmt, size_t nfmt, char **ep,
+	size_t *restrict fi)
+{
+/* try formats FMT in order, FI is set to the index of the one that
+ * succeeded, or to NFMT */
+	struct dt_dt_s res = {DT_UNK};
+	size_t i = 0U;
+
+	if (nfmt == 0) {
+		res = dt_strpdt(str, NULL, ep);
+	} else {
+		for (; i < nfmt; i++) {
+			if (!dt_unk_p(res = dt_strpdt(str, fmt[i], ep))) {
+				break;
+			}
+		}
+	}
+	*fi = i;
+	return res;
+}
+
+int
+dt_io_stats_init(const char *how, char *const *fmt, size_t nfmt, size_t nslot)
+{
+	const size_t z = sizeof(*dt_io_stats) + (nfmt + 1U) * sizeof(size_t);
+	void *p;
+
+	if (how == NULL || !strcmp(how, "kv")) {
+		stats.jsonp = false;
+	} else if (!strcmp(how, "json")) {
+		stats.jsonp = true;
+	} else {
+		error("Error: unknown statistics format `%s'", how);
+		return -1;
+	}
+	/* slots are cache-line aligned and shared with worker processes */
+	stats.slotz = (z + 63U) & ~(size_t)63U;
+	stats.nslot = nslot ?: 1U;
+	p = mmap(NULL, stats.nslot * stats.slotz, PROT_READ | PROT_WRITE,
+		 MAP_SHARED | MAP_ANON, -1, 0);
+	if (UNLIKELY(p == MAP_FAILED)) {
+		serror("Error: cannot allocate statistics");
+		return -1;
+	}
+	stats.slots = p;
+	stats.fmt = fmt;
+	stats.nfmt = nfmt;
+	clock_gettime(CLOCK_MONOTONIC, &stats.ts0);
+	stats.tck0 = __stats_now();
+	dt_io_stats = stats.slots;
+	return 0;
+}
+
+void
+dt_io_stats_slot(size_t slot)
+{
+	if (dt_io_stats == NULL || slot >= stats.nslot) {
+		return;
+	}
+	dt_io_stats = __stats_slot(slot);
+	/* zone caches are process-local copies, remember where we are */
+	dt_io_zone_stats(&stats.nzhit, &stats.nzmiss);
+	return;
+}
+
+void
+dt_io_stats_sync(void)
+{
+	if (dt_io_stats != NULL) {
+		size_t h, m;
+
+		dt_io_zone_stats(&h, &m);
+		/* counters only shrink when zones were let go of,
+		 * and those have been deposited before */
+		if (h >= stats.nzhit && m >= stats.nzmiss) {
+			dt_io_stats->nzhit += h - stats.nzhit;
+			dt_io_stats->nzmiss += m - stats.nzmiss;
+		}
+		stats.nzhit = h;
+		stats.nzmiss = m;
+	}
+	return;
+}
+
+void
+dt_io_stats_fmt(const char *fmt)
+{
+	if (dt_io_stats == NULL) {
+		return;
+	}
+	for (size_t i = 0U; i < stats.nfmt; i++) {
+		if (fmt == stats.fmt[i]) {
+			dt_io_stats->nfmt[i]++;
+			return;
+		}
+	}
+	/* must be a default then */
+	dt_io_stats->nfmt[stats.nfmt]++;
+	return;
+}
+
+void
+dt_io_stats_fini(void)
+{
+	static const char *const stg[DT_IO_NSTG] = {
+		[DT_IO_STG_READ] = "read",
+		[DT_IO_STG_SCAN] = "scan",
+		[DT_IO_STG_PARSE] = "parse",
+		[DT_IO_STG_CONV] = "convert",
+		[DT_IO_STG_FMT] = "format",
+		[DT_IO_STG_WRITE] = "write",
+	};
+	struct dt_io_stats_s *tot;
+	struct timespec ts1;
+	uint64_t tck1;
+	double secs, spt;
+	const char *sep;
+
+	if (dt_io_stats == NULL) {
+		return;
+	}
+	tck1 = __stats_now();
+	clock_gettime(CLOCK_MONOTONIC, &ts1);
+	secs = (double)(ts1.tv_sec - stats.ts0.tv_sec) +
+		(double)(ts1.tv_nsec - stats.ts0.tv_nsec) / 1000000000;
+	/* seconds per tick */
+	spt = tck1 > stats.tck0 ? secs / (double)(tck1 - stats.tck0) : 0;
+
+	/* fold everything into slot 0 */
+	dt_io_stats = tot = stats.slots;
+	dt_io_stats_sync();
+	for (size_t i = 1U; i < stats.nslot; i++) {
+		const struct dt_io_stats_s *x = __stats_slot(i);
+
+		tot->nrd += x->nrd;
+		tot->nln += x->nln;
+		tot->nwr += x->nwr;
+		tot->nok += x->nok;
+		tot->nfail += x->nfail;
+		tot->nzhit += x->nzhit;
+		tot->nzmiss += x->nzmiss;
+		for (size_t j = 0U; j < DT_IO_NSTG; j++) {
+			tot->tck[j] += x->tck[j];
+		}
+		for (size_t j = 0U; j <= stats.nfmt; j++) {
+			tot->nfmt[j] += x->nfmt[j];
+		}
+	}
+	/* no more counting from here on */
+	dt_io_stats = NULL;
+
+#define KV(k, f, v)							\
+	fprintf(stderr, stats.jsonp ? "%s\"%s\": " f : "%s%s=" f, sep, k, v), \
+		sep = stats.jsonp ? ", " : "\n"
+	sep = stats.jsonp ? "{" : "";
+	KV("bytes_read", "%zu", tot->nrd);
+	KV("lines_read", "%zu", tot->nln);
+	KV("bytes_written", "%zu", tot->nwr);
+	KV("parsed", "%zu", tot->nok);
+	KV("failed", "%zu", tot->nfail);
+	for (size_t i = 0U; i < stats.nfmt; i++) {
+		char k[32U];
+
+		snprintf(k, sizeof(k), "parsed_fmt%zu", i + 1U);
+		KV(k, "%zu", tot->nfmt[i]);
+	}
+	if (!stats.nfmt || tot->nfmt[stats.nfmt]) {
+		KV("parsed_default", "%zu", tot->nfmt[stats.nfmt]);
+	}
+	KV("zone_cache_hits", "%zu", tot->nzhit);
+	KV("zone_cache_misses", "%zu", tot->nzmiss);
+	for (size_t i = 0U; i < DT_IO_NSTG; i++) {
+		char k[32U];
+
+		snprintf(k, sizeof(k), "time_%s", stg[i]);
+		KV(k, "%.6f", (double)tot->tck[i] * spt);
+	}
+	KV("time_total", "%.6f", secs);
+	KV("bytes_per_sec", "%.0f", secs > 0 ? (double)tot->nrd / secs : 0);
+	KV("lines_per_sec", "%.0f", secs > 0 ? (double)tot->nln / secs : 0);
+	fputs(stats.jsonp ? "}\n" : "\n", stderr);
+#undef KV
+
+	munmap(stats.slots, stats.nslot * stats.slotz);
+	stats.slots = NULL;
+	return;
+}
+
 
 #include "strpdt-special.c"
 
@@ -123,16 +365,19 @@ dt_io_strpdt(
 			break;
 		}
 		return res;
-	} else if (nfmt == 0) {
-		res = dt_strpdt(str, NULL, NULL);
 	} else {
-		for (size_t i = 0; i < nfmt; i++) {
-			if (!dt_unk_p(res = dt_strpdt(str, fmt[i], NULL))) {
-				break;
-			}
+		uint64_t t = dt_io_stats_tick();
+		size_t fi;
+
+		res = __strpdt_ep(str, fmt, nfmt, NULL, &fi);
+		if (UNLIKELY(dt_io_stats != NULL)) {
+			__stats_res(res, fmt, fi);
+			dt_io_stats_lap(DT_IO_STG_PARSE, &t);
 		}
+		res = dtz_forgetz(res, zone);
+		dt_io_stats_lap(DT_IO_STG_CONV, &t);
 	}
-	return dtz_forgetz(res, zone);
+	return res;
 }
 
 struct dt_dt_s
@@ -141,18 +386,17 @@ dt_io_strpdt_ep(
 	char *const *fmt, size_t nfmt, char **ep,
 	zif_t zone)
 {
-	struct dt_dt_s res = {DT_UNK};
+	uint64_t t = dt_io_stats_tick();
+	size_t fi;
+	struct dt_dt_s res = __strpdt_ep(str, fmt, nfmt, ep, &fi);
 
-	if (nfmt == 0) {
-		res = dt_strpdt(str, NULL, ep);
-	} else {
-		for (size_t i = 0; i < nfmt; i++) {
-			if (!dt_unk_p(res = dt_strpdt(str, fmt[i], ep))) {
-				break;
-			}
-		}
+	if (UNLIKELY(dt_io_stats != NULL)) {
+		__stats_res(res, fmt, fi);
+		dt_io_stats_lap(DT_IO_STG_PARSE, &t);
 	}
-	return dtz_forgetz(res, zone);
+	res = dtz_forgetz(res, zone);
+	dt_io_stats_lap(DT_IO_STG_CONV, &t);
+	return res;
 }
 
 struct dt_dt_s
@@ -162,16 +406,23 @@ dt_io_find_strpdt(
 	zif_t zone)
 {
 	const char *__sp = str;
+	uint64_t t = dt_io_stats_tick();
 	struct dt_dt_s d;
+	size_t fi;
 
-	d = dt_io_strpdt_ep(__sp, fmt, nfmt, ep, zone);
+	d = __strpdt_ep(__sp, fmt, nfmt, ep, &fi);
 	if (dt_unk_p(d)) {
 		while ((__sp = strstr(__sp, needle)) &&
-		       (d = dt_io_strpdt_ep(
-				__sp += needlen, fmt, nfmt, ep, zone),
+		       (d = __strpdt_ep(__sp += needlen, fmt, nfmt, ep, &fi),
 			dt_unk_p(d)));
 	}
 	*sp = (char*)__sp;
+	if (UNLIKELY(dt_io_stats != NULL)) {
+		__stats_res(d, fmt, fi);
+		dt_io_stats_lap(DT_IO_STG_SCAN, &t);
+	}
+	d = dtz_forgetz(d, zone);
+	dt_io_stats_lap(DT_IO_STG_CONV, &t);
 	return d;
 }
 
@@ -186,6 +437,9 @@ dt_io_find_strpdt2(
 	const char *needle = needles->needle;
 	const char *p = str;
 	const char *const zp = str + len;
+	/* format that matched, for statistics */
+	const char *hfmt = NULL;
+	uint64_t t = dt_io_stats_tick();
 
 	for (; *(p = xmempbrk(p, zp - p, needle)); p++) {
 		/* find the offset */
@@ -209,6 +463,7 @@ dt_io_find_strpdt2(
 			for (; q < zp && q <= r; q++) {
 				if (!dt_unk_p(d = dt_strpdt(q, fmt, ep))) {
 					p = q;
+					hfmt = fmt;
 					goto found;
 				}
 			}
@@ -253,6 +508,7 @@ dt_io_find_strpdt2(
 			     q < zp && *q >= '0' && *q <= '9'; q++) {
 				if ((--f.off_min <= 0) &&
 				    !dt_unk_p(d = dt_strpdt(p, fmt, ep))) {
+					hfmt = fmt;
 					goto found;
 				}
 			}
@@ -286,6 +542,7 @@ dt_io_find_strpdt2(
 				}
 				if ((--f.off_min <= 0) &&
 				    !dt_unk_p(d = dt_strpdt(p, fmt, ep))) {
+					hfmt = fmt;
 					goto found;
 				}
 			}
@@ -301,6 +558,7 @@ dt_io_find_strpdt2(
 			for (int8_t j = f.off_min; j <= f.off_max; j++) {
 				if (!dt_unk_p(d = dt_strpdt(p + j, fmt, ep))) {
 					p += j;
+					hfmt = fmt;
 					goto found;
 				}
 			}
@@ -310,13 +568,25 @@ dt_io_find_strpdt2(
 	*ep = (char*)(p = str);
 found:
 	*sp = (char*)p;
-	return dtz_forgetz(d, zone);
+	if (UNLIKELY(dt_io_stats != NULL)) {
+		if (dt_unk_p(d)) {
+			dt_io_stats->nfail++;
+		} else {
+			dt_io_stats->nok++;
+			dt_io_stats_fmt(hfmt);
+		}
+		dt_io_stats_lap(DT_IO_STG_SCAN, &t);
+	}
+	d = dtz_forgetz(d, zone);
+	dt_io_stats_lap(DT_IO_STG_CONV, &t);
+	return d;
 }
 
 int
 dt_io_write(struct dt_dt_s d, const char *fmt, zif_t zone, int apnd_ch)
 {
 	static char buf[256];
+	uint64_t t = dt_io_stats_tick();
 	size_t n;
 
 	if (zone != NULL) {
@@ -326,7 +596,9 @@ dt_io_write(struct dt_dt_s d, const char *fmt, zif_t zone, int apnd_ch)
 		d.zdiff = 0U;
 		d.neg = 0U;
 	}
+	dt_io_stats_lap(DT_IO_STG_CONV, &t);
 	n = dt_io_strfdt(buf, sizeof(buf), fmt, d, apnd_ch);
+	dt_io_stats_lap(DT_IO_STG_FMT, &t);
 	__io_write(buf, n, stdout);
 	return (n > 0) - 1;
 }
@@ -654,6 +926,436 @@ dt_io_unescape(char *s)
 	return;
 }
 
+
+/* binary records */
+#define MILLIS_PER_SEC	(1000)
+
+static inline int64_t
+__fldiv(int64_t x, int64_t y, int64_t *rem)
+{
+/* floored division, REM will be non-negative */
+	int64_t q = x / y;
+	int64_t r = x % y;
+
+	if (r < 0) {
+		q--;
+		r += y;
+	}
+	*rem = r;
+	return q;
+}
+
+dt_io_bin_t
+dt_io_bin(const char *spec)
+{
+	static const char *const bins[DT_IO_NBIN] = {
+		[DT_IO_BIN_I32LE] = "i32le",
+		[DT_IO_BIN_I64LE] = "i64le",
+		[DT_IO_BIN_I64LE_MS] = "i64le-ms",
+		[DT_IO_BIN_I64LE_NS] = "i64le-ns",
+		[DT_IO_BIN_YMDHMS] = "ymdhms",
+	};
+
+	for (size_t i = DT_IO_BIN_UNK + 1U; i < countof(bins); i++) {
+		if (!strcasecmp(spec, bins[i])) {
+			return (dt_io_bin_t)i;
+		}
+	}
+	return DT_IO_BIN_UNK;
+}
+
+struct dt_io_ts_s
+dt_io_bin_get(dt_io_bin_t typ, const char *rec)
+{
+	struct dt_io_ts_s res = {0};
+	int64_t x;
+	int64_t r;
+
+	switch (typ) {
+		int32_t x32;
+		dt_ymdhms_t ymdhms;
+
+	case DT_IO_BIN_I32LE:
+		memcpy(&x32, rec, sizeof(x32));
+		res.s = (int32_t)le32toh(x32);
+		break;
+	case DT_IO_BIN_I64LE:
+		memcpy(&x, rec, sizeof(x));
+		res.s = (int64_t)le64toh(x);
+		break;
+	case DT_IO_BIN_I64LE_MS:
+		memcpy(&x, rec, sizeof(x));
+		res.s = __fldiv((int64_t)le64toh(x), MILLIS_PER_SEC, &r);
+		res.ns = (uint32_t)r * (NANOS_PER_SEC / MILLIS_PER_SEC);
+		break;
+	case DT_IO_BIN_I64LE_NS:
+		memcpy(&x, rec, sizeof(x));
+		res.s = __fldiv((int64_t)le64toh(x), NANOS_PER_SEC, &r);
+		res.ns = (uint32_t)r;
+		break;
+	case DT_IO_BIN_YMDHMS: {
+		struct dt_dt_s d = {DT_UNK};
+
+		memcpy(&ymdhms, rec, sizeof(ymdhms));
+		d.d = dt_make_ymd(ymdhms.y, ymdhms.m, ymdhms.d);
+		d.t.hms.h = ymdhms.H;
+		d.t.hms.m = ymdhms.M;
+		d.t.hms.s = ymdhms.S;
+		dt_make_sandwich(&d, DT_YMD, DT_HMS);
+		res.s = dt_to_unix_epoch(d);
+		break;
+	}
+	default:
+		break;
+	}
+	return res;
+}
+
+void
+dt_io_bin_put(char *restrict rec, dt_io_bin_t typ, struct dt_io_ts_s ts)
+{
+	uint64_t x;
+
+	switch (typ) {
+		uint32_t x32;
+
+	case DT_IO_BIN_I32LE:
+		x32 = htole32((uint32_t)ts.s);
+		memcpy(rec, &x32, sizeof(x32));
+		break;
+	case DT_IO_BIN_I64LE:
+		x = htole64((uint64_t)ts.s);
+		memcpy(rec, &x, sizeof(x));
+		break;
+	case DT_IO_BIN_I64LE_MS:
+		x = ts.s * MILLIS_PER_SEC + ts.ns / (NANOS_PER_SEC / MILLIS_PER_SEC);
+		x = htole64(x);
+		memcpy(rec, &x, sizeof(x));
+		break;
+	case DT_IO_BIN_I64LE_NS:
+		x = ts.s * NANOS_PER_SEC + ts.ns;
+		x = htole64(x);
+		memcpy(rec, &x, sizeof(x));
+		break;
+	case DT_IO_BIN_YMDHMS: {
+		struct dt_dt_s d = dt_io_ts2dt(ts);
+		dt_ymdhms_t ymdhms = {0};
+
+		ymdhms.y = d.d.ymd.y;
+		ymdhms.m = d.d.ymd.m;
+		ymdhms.d = d.d.ymd.d;
+		ymdhms.H = d.t.hms.h;
+		ymdhms.M = d.t.hms.m;
+		ymdhms.S = d.t.hms.s;
+		memcpy(rec, &ymdhms, sizeof(ymdhms));
+		break;
+	}
+	default:
+		break;
+	}
+	return;
+}
+
+struct dt_dt_s
+dt_io_ts2dt(struct dt_io_ts_s ts)
+{
+	static dt_daisy_t unix_base;
+	struct dt_dt_s res = {DT_UNK};
+	int64_t ss;
+	int64_t dd;
+
+	if (UNLIKELY(!unix_base)) {
+		unix_base = dt_conv_to_daisy(dt_make_ymd(1970U, 1U, 1U));
+	}
+	dd = __fldiv(ts.s, SECS_PER_DAY, &ss);
+	res.d.ymd = __daisy_to_ymd((dt_daisy_t)(dd + unix_base));
+	res.t.hms.s = ss % SECS_PER_MIN;
+	ss /= SECS_PER_MIN;
+	res.t.hms.m = ss % MINS_PER_HOUR;
+	ss /= MINS_PER_HOUR;
+	res.t.hms.h = ss;
+	res.t.hms.ns = ts.ns;
+	dt_make_sandwich(&res, DT_YMD, DT_HMS);
+	return res;
+}
+
+struct dt_io_ts_s
+dt_io_dt2ts(struct dt_dt_s d)
+{
+	struct dt_io_ts_s res = {.s = dt_to_unix_epoch(d)};
+
+	if (dt_sandwich_p(d) || dt_sandwich_only_t_p(d)) {
+		res.ns = d.t.hms.ns;
+	} else if (d.typ == DT_NSEXY) {
+		/* floored, like the seconds */
+		const int32_t ns = d.nsexy % (dt_nsexy_t)NANOS_PER_SEC;
+		res.ns = ns < 0 ? ns + (int32_t)NANOS_PER_SEC : ns;
+	}
+	return res;
+}
+
+struct dt_io_ts_s
+dt_io_ts_zshift(struct dt_io_ts_s ts, zif_t z, bool toutcp)
+{
+/* zoneinfo is 32 bits only, use the offsets at the boundaries
+ * for everything beyond */
+	int32_t t;
+
+	if (z == NULL) {
+		return ts;
+	} else if (ts.s < INT32_MIN) {
+		t = INT32_MIN;
+	} else if (ts.s > INT32_MAX) {
+		t = INT32_MAX;
+	} else {
+		t = (int32_t)ts.s;
+	}
+	if (toutcp) {
+		ts.s += zif_utc_time(z, t) - t;
+	} else {
+		ts.s += zif_local_time(z, t) - t;
+	}
+	return ts;
+}
+
+struct dt_io_ts_s
+dt_io_ts_zconv(struct dt_io_ts_s ts, zif_pair_t zp)
+{
+/* like dt_io_ts_zshift() to UTC and back out again but in one go */
+	int32_t t;
+
+	if (zp == NULL) {
+		return ts;
+	} else if (ts.s < INT32_MIN) {
+		t = INT32_MIN;
+	} else if (ts.s > INT32_MAX) {
+		t = INT32_MAX;
+	} else {
+		t = (int32_t)ts.s;
+	}
+	ts.s += zif_pair_conv(zp, t) - t;
+	return ts;
+}
+
+
+/* column mode */
+int
+dt_io_cols(struct dt_io_cols_s *restrict tgt, const char *dlm, const char *keys)
+{
+/* KEYS is a comma separated list of 1-based field numbers or ranges
+ * of field numbers, like cut(1)'s -f LIST, i.e. N, N-M, N- or -M */
+	const char *kp = keys;
+	char *on;
+
+	memset(tgt, 0, sizeof(*tgt));
+	if (dlm == NULL) {
+		tgt->dlm = '\t';
+	} else if (dlm[0U] && !dlm[1U]) {
+		tgt->dlm = *dlm;
+	} else {
+		error("Error: delimiter must be a single character");
+		return -1;
+	}
+
+	do {
+		/* -M starts at the first field */
+		long int beg = 1;
+		long int end;
+		bool openp = false;
+
+		if (*kp != '-') {
+			beg = strtol(kp, &on, 10);
+			if (UNLIKELY(on == kp)) {
+				goto inval;
+			}
+			kp = on;
+		}
+		if (*kp != '-') {
+			/* just N */
+			end = beg;
+		} else if (kp[1U] == ',' || !kp[1U]) {
+			/* N- goes up to the last field, but - alone won't do */
+			if (UNLIKELY(kp == keys || kp[-1] == ',')) {
+				goto inval;
+			}
+			on = (char*)kp + 1;
+			end = beg;
+			openp = true;
+		} else {
+			end = strtol(++kp, &on, 10);
+			if (UNLIKELY(on == kp)) {
+				goto inval;
+			}
+		}
+		if (UNLIKELY(*on && *on != ',')) {
+			goto inval;
+		} else if (UNLIKELY(beg <= 0 || end < beg)) {
+			goto inval;
+		} else if (UNLIKELY(end >= (long int)DT_IO_MAX_COLS)) {
+			error("Error: field number too large `%ld'", end);
+			return -1;
+		} else if (openp) {
+			/* split lines as far as we can */
+			end = DT_IO_MAX_COLS;
+		}
+		for (unsigned int i = beg - 1; i < (unsigned int)end; i++) {
+			tgt->sel[i / 64U] |= 1ULL << (i % 64U);
+		}
+		if (openp) {
+			tgt->ncols = DT_IO_MAX_COLS;
+		} else if ((unsigned int)end >= tgt->ncols) {
+			/* one more column for the rest of the line */
+			tgt->ncols = end + 1U;
+		}
+		kp = on + 1;
+	} while (*on);
+	return 0;
+
+inval:
+	error("Error: invalid field list `%s'", keys);
+	return -1;
+}
+
+
+/* input files, possibly compressed */
+static const struct {
+	const char *cmd;
+	size_t nmag;
+	const unsigned char mag[6U];
+} decomps[] = {
+	{"gzip", 2U, {0x1fU, 0x8bU}},
+	{"xz", 6U, {0xfdU, '7', 'z', 'X', 'Z', 0x00U}},
+	{"zstd", 4U, {0x28U, 0xb5U, 0x2fU, 0xfdU}},
+	{"bzip2", 3U, {'B', 'Z', 'h'}},
+};
+
+static pid_t
+spawn_decomp(int *restrict outfd, const int infd, const char *cmd)
+{
+	char *cmdline[] = {(char*)cmd, "-dc", NULL};
+	pid_t decp;
+	/* to snarf off traffic from the child */
+	int intfd[2];
+
+	if (pipe(intfd) < 0) {
+		serror("pipe setup from %s failed", cmd);
+		return -1;
+	}
+
+	switch ((decp = vfork())) {
+	case -1:
+		/* i am an error */
+		serror("vfork for %s failed", cmd);
+		close(intfd[0]);
+		close(intfd[1]);
+		return -1;
+
+	default:
+		/* i am the parent */
+		close(intfd[1]);
+		*outfd = intfd[0];
+		return decp;
+
+	case 0:
+		/* i am the child */
+		dup2(infd, STDIN_FILENO);
+		dup2(intfd[1], STDOUT_FILENO);
+		close(intfd[0]);
+
+		execvp(cmd, cmdline);
+		serror("execvp(%s) failed", cmd);
+		_exit(EXIT_FAILURE);
+	}
+}
+
+int
+dt_io_open(const char *fn, pid_t *restrict dec)
+{
+/* we only sniff seekable descriptors as there's no way to push
+ * bytes back into a pipe, non-seekable input is passed on verbatim */
+	unsigned char mag[6U];
+	ssize_t nmag;
+	off_t cur;
+	int fd;
+
+	*dec = 0;
+	if (fn == NULL || (fn[0U] == '-' && fn[1U] == '\0')) {
+		/* stdin then innit */
+		fd = STDIN_FILENO;
+	} else if ((fd = open(fn, O_RDONLY)) < 0) {
+		serror("Error: cannot open file `%s'", fn);
+		return -1;
+	}
+
+	if ((cur = lseek(fd, 0, SEEK_CUR)) < 0 ||
+	    (nmag = pread(fd, mag, sizeof(mag), cur)) <= 0) {
+		return fd;
+	}
+	for (size_t i = 0U; i < countof(decomps); i++) {
+		int decfd;
+
+		if ((size_t)nmag < decomps[i].nmag ||
+		    memcmp(mag, decomps[i].mag, decomps[i].nmag)) {
+			continue;
+		} else if ((*dec = spawn_decomp(&decfd, fd, decomps[i].cmd)) < 0) {
+			*dec = 0;
+			break;
+		}
+		/* the child has its own copy now */
+		if (fd != STDIN_FILENO) {
+			close(fd);
+		}
+		return decfd;
+	}
+	return fd;
+}
+
+int
+dt_io_close(int fd, pid_t dec)
+{
+	int rc = 0;
+
+	if (fd != STDIN_FILENO) {
+		close(fd);
+	}
+	if (dec > 0) {
+		int st;
+
+		while (waitpid(dec, &st, 0) != dec);
+		if (!WIFEXITED(st) || WEXITSTATUS(st)) {
+			error("Error: decompressor failed");
+			rc = -1;
+		}
+	}
+	return rc;
+}
+
+
+/* holiday calendars */
+static bizcal_t bizcal;
+
+int
+dt_io_bizcal(const char *fn)
+{
+	if ((bizcal = bzc_open(fn)) == NULL) {
+		serror("Error: cannot open calendar file `%s'", fn);
+		return -1;
+	}
+	dt_set_bizcal(bizcal);
+	return 0;
+}
+
+void
+dt_io_clear_bizcal(void)
+{
+	if (bizcal != NULL) {
+		dt_set_bizcal(NULL);
+		bzc_close(bizcal);
+		bizcal = NULL;
+	}
+	return;
+}
+
 
 /* duration parser */
 /* we parse durations ourselves so we can cope with the
@@ -12,8 +12,11 @@
 #include <string.h>
 /* for strcasecmp() */
 #include <strings.h>
+/* for pid_t */
+#include <sys/types.h>
 #include "dt-core.h"
 #include "dt-io-zone.h"
+#include "dt-io-stats.h"
 #include "nifty.h"
 
 typedef enum {
@@ -73,6 +76,40 @@ struct __strpdtdur_st_s {
 };
 
 
+/* column mode, a cut(1)-like selection of fields */
+#define DT_IO_MAX_COLS	(512U)
+
+struct dt_io_cols_s {
+	/* field delimiter */
+	char dlm;
+	/* number of columns to chop lines into, the last one is the rest */
+	unsigned int ncols;
+	/* bitset of selected (0-based) columns */
+	uint64_t sel[DT_IO_MAX_COLS / 64U];
+};
+
+/* binary records, all little endian, the ymdhms one is native */
+typedef enum {
+	DT_IO_BIN_UNK,
+	/* seconds since epoch */
+	DT_IO_BIN_I32LE,
+	DT_IO_BIN_I64LE,
+	/* milli- and nanoseconds since epoch */
+	DT_IO_BIN_I64LE_MS,
+	DT_IO_BIN_I64LE_NS,
+	/* packed dt_ymdhms_t */
+	DT_IO_BIN_YMDHMS,
+	DT_IO_NBIN,
+} dt_io_bin_t;
+
+/* seconds since epoch plus a nanosecond remainder, the common
+ * denominator of all binary records */
+struct dt_io_ts_s {
+	int64_t s;
+	uint32_t ns;
+};
+
+
 /* public API */
 extern dt_strpdt_special_t dt_io_strpdt_special(const char *str);
 extern struct dt_dt_s
@@ -111,6 +148,43 @@ build_needle(grep_atom_t atoms, size_t natoms, char *const *fmt, size_t nfmt);
 
 extern void dt_io_unescape(char *s);
 
+/* binary records, return the record type named SPEC */
+extern dt_io_bin_t dt_io_bin(const char *spec);
+
+/* decode the record REC of type TYP */
+extern struct dt_io_ts_s dt_io_bin_get(dt_io_bin_t typ, const char *rec);
+
+/* encode TS as record of type TYP into REC */
+extern void dt_io_bin_put(char *restrict rec, dt_io_bin_t typ, struct dt_io_ts_s);
+
+/* convert between time stamps and date/times */
+extern struct dt_dt_s dt_io_ts2dt(struct dt_io_ts_s);
+extern struct dt_io_ts_s dt_io_dt2ts(struct dt_dt_s);
+
+/* shift TS from local time in zone Z to UTC if TOUTCP, or back */
+extern struct dt_io_ts_s dt_io_ts_zshift(struct dt_io_ts_s, zif_t z, bool toutcp);
+
+/* shift TS from local time in the pair's from zone to its to zone */
+extern struct dt_io_ts_s dt_io_ts_zconv(struct dt_io_ts_s, zif_pair_t zp);
+
+/* column mode, parse key spec KEYS and delimiter DLM into TGT */
+extern int
+dt_io_cols(struct dt_io_cols_s *restrict tgt, const char *dlm, const char *keys);
+
+/* open FN for reading (stdin if NULL or `-'), gzip, xz, zstd or bzip2
+ * compressed files are piped through a decompressor child whose pid
+ * is put into DEC, or 0 if none was spawned */
+extern int dt_io_open(const char *fn, pid_t *restrict dec);
+
+/* close FD as obtained by dt_io_open() and reap decompressor DEC */
+extern int dt_io_close(int fd, pid_t dec);
+
+/* use the compiled holiday calendar in FN for business day arithmetic */
+extern int dt_io_bizcal(const char *fn);
+
+/* unload the holiday calendar again */
+extern void dt_io_clear_bizcal(void);
+
 /* error messages, warnings, etc. */
 extern __attribute__((format(printf, 1, 2))) void error(const char *fmt, ...);
 
@@ -160,16 +234,27 @@ dt_io_strfdt(
 static __attribute__((unused)) size_t
 __io_write(const char *line, size_t llen, FILE *where)
 {
+	uint64_t t = dt_io_stats_tick();
+	size_t res;
+
 #if defined __GLIBC__
-	return fwrite_unlocked(line, sizeof(*line), llen, where);
+	res = fwrite_unlocked(line, sizeof(*line), llen, where);
 #else  /* !__GLIBC__ */
-	return fwrite(line, sizeof(*line), llen, where);
+	res = fwrite(line, sizeof(*line), llen, where);
 #endif	/* __GLIBC__ */
+	if (UNLIKELY(dt_io_stats != NULL)) {
+		dt_io_stats_lap(DT_IO_STG_WRITE, &t);
+		dt_io_stats->nwr += res;
+	}
+	return res;
 }
 
 static __attribute__((unused)) int
 __io_putc(int c, FILE *where)
 {
+	if (UNLIKELY(dt_io_stats != NULL)) {
+		dt_io_stats->nwr++;
+	}
 #if defined __GLIBC__
 	return fputc_unlocked(c, where);
 #else  /* !__GLIBC__ */
@@ -201,6 +286,25 @@ __io_eof_p(FILE *fp)
 #endif	/* __GLIBC__ */
 }
 
+static inline size_t
+dt_io_bin_width(dt_io_bin_t typ)
+{
+	static const size_t wid[DT_IO_NBIN] = {
+		[DT_IO_BIN_I32LE] = sizeof(int32_t),
+		[DT_IO_BIN_I64LE] = sizeof(int64_t),
+		[DT_IO_BIN_I64LE_MS] = sizeof(int64_t),
+		[DT_IO_BIN_I64LE_NS] = sizeof(int64_t),
+		[DT_IO_BIN_YMDHMS] = sizeof(dt_ymdhms_t),
+	};
+	return wid[typ];
+}
+
+static inline bool
+dt_io_col_p(const struct dt_io_cols_s *cols, unsigned int cno)
+{
+	return (cols->sel[cno / 64U] >> (cno % 64U)) & 1U;
+}
+
 static inline void
 dt_io_warn_strpdt(const char *inp)
 {
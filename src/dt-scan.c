@@ -0,0 +1,227 @@
+/*** dt-scan.c -- push-style date/time scanner
+ *
+ * Copyright (C) 2019 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of dateutils.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "dt-scan.h"
+#include "dt-io.h"
+#include "nifty.h"
+
+/* initial size of the carry-over buffer */
+#define INI_CSZ		(256U)
+
+struct dt_scan_s {
+	struct grep_atom_soa_s ndl;
+	zif_t zone;
+	dt_scan_f cb;
+	void *clo;
+
+	/* stream offset of the next byte to be fed */
+	size_t off;
+
+	/* carry-over of incomplete lines, always \0 terminated */
+	char *cbuf;
+	size_t clen;
+	size_t csz;
+
+	/* the atoms behind NDL */
+	struct grep_atom_s atoms[];
+};
+
+
+static bool
+__nl_fmt_p(const char *fmt)
+{
+/* check if FMT would match a newline */
+	for (const char *fp = fmt; (fp = strchr(fp, '%')) != NULL; fp++) {
+		switch (*++fp) {
+		case 'n':
+			return true;
+		case '\0':
+			return false;
+		default:
+			break;
+		}
+	}
+	return false;
+}
+
+static int
+carry(dt_scan_t ctx, const char *buf, size_t len)
+{
+	if (UNLIKELY(ctx->clen + len >= ctx->csz)) {
+		size_t nsz = ctx->csz ?: INI_CSZ;
+		char *nu;
+
+		while ((nsz *= 2U) <= ctx->clen + len);
+		if (UNLIKELY((nu = realloc(ctx->cbuf, nsz)) == NULL)) {
+			return -1;
+		}
+		ctx->cbuf = nu;
+		ctx->csz = nsz;
+	}
+	memcpy(ctx->cbuf + ctx->clen, buf, len);
+	ctx->cbuf[ctx->clen += len] = '\0';
+	return 0;
+}
+
+static int
+scan_line(dt_scan_t ctx, const char *line, size_t llen, size_t off)
+{
+/* LINE must be \0 terminated at LLEN, OFF is LINE's stream offset */
+	const char *const zp = line + llen;
+
+	for (const char *lp = line; lp < zp;) {
+		struct dt_dt_s d;
+		char *sp = NULL;
+		char *ep = NULL;
+		int rc;
+
+		d = dt_io_find_strpdt2(lp, zp - lp, &ctx->ndl, &sp, &ep, ctx->zone);
+		if (dt_unk_p(d) || UNLIKELY(ep <= sp)) {
+			break;
+		} else if ((rc = ctx->cb(ctx->clo, off + (sp - line), ep - sp, d))) {
+			return rc;
+		}
+		/* there might be more on this line */
+		lp = ep;
+	}
+	return 0;
+}
+
+
+/* public API */
+dt_scan_t
+make_dt_scan(char *const *fmt, size_t nfmt, zif_t zone, dt_scan_f cb, void *clo)
+{
+	/* at least 2 for the standard needles, like dgrep et al */
+	const size_t natoms = (nfmt | 7U) + 1U;
+	dt_scan_t res;
+
+	for (size_t i = 0U; i < nfmt; i++) {
+		if (UNLIKELY(__nl_fmt_p(fmt[i]))) {
+			return NULL;
+		}
+	}
+	if (UNLIKELY(cb == NULL)) {
+		return NULL;
+	} else if ((res = calloc(1, sizeof(*res) + natoms * sizeof(*res->atoms)))
+		   == NULL) {
+		return NULL;
+	}
+	res->ndl = build_needle(res->atoms, natoms, fmt, nfmt);
+	res->zone = zone;
+	res->cb = cb;
+	res->clo = clo;
+	return res;
+}
+
+void
+free_dt_scan(dt_scan_t ctx)
+{
+	if (UNLIKELY(ctx == NULL)) {
+		return;
+	}
+	if (ctx->cbuf != NULL) {
+		free(ctx->cbuf);
+	}
+	free(ctx);
+	return;
+}
+
+int
+dt_scan_feed(dt_scan_t ctx, char *buf, size_t len)
+{
+	const char *const zp = buf + len;
+	char *bp = buf;
+	char *nl;
+	int rc = 0;
+
+	if (ctx->clen) {
+		/* complete the carried-over line first */
+		const size_t coff = ctx->off - ctx->clen;
+
+		if ((nl = memchr(bp, '\n', len)) == NULL) {
+			rc = carry(ctx, bp, len);
+			goto out;
+		} else if (UNLIKELY((rc = carry(ctx, bp, nl - bp)) < 0)) {
+			goto out;
+		}
+		rc = scan_line(ctx, ctx->cbuf, ctx->clen, coff);
+		ctx->clen = 0U;
+		if (UNLIKELY(rc)) {
+			goto out;
+		}
+		bp = nl + 1U;
+	}
+	/* complete lines, scanned in place with the \n poked out */
+	for (; (nl = memchr(bp, '\n', zp - bp)) != NULL; bp = nl + 1U) {
+		*nl = '\0';
+		rc = scan_line(ctx, bp, nl - bp, ctx->off + (bp - buf));
+		*nl = '\n';
+		if (UNLIKELY(rc)) {
+			goto out;
+		}
+	}
+	/* keep the rest for later */
+	rc = carry(ctx, bp, zp - bp);
+out:
+	if (UNLIKELY(rc)) {
+		/* whatever's carried over is incomplete now */
+		ctx->clen = 0U;
+	}
+	ctx->off += len;
+	return rc;
+}
+
+int
+dt_scan_flush(dt_scan_t ctx)
+{
+	int rc = 0;
+
+	if (ctx->clen) {
+		rc = scan_line(ctx, ctx->cbuf, ctx->clen, ctx->off - ctx->clen);
+		ctx->clen = 0U;
+	}
+	return rc;
+}
+
+/* dt-scan.c ends here */
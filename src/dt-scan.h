@@ -0,0 +1,82 @@
+/*** dt-scan.h -- push-style date/time scanner
+ *
+ * Copyright (C) 2019 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of dateutils.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_dt_scan_h_
+#define INCLUDED_dt_scan_h_
+
+#include <stddef.h>
+#include "dt-core.h"
+#include "dt-core-tz-glue.h"
+
+/* A push-style scanner, other than prchunk it owns no file descriptor
+ * and never reads, it is simply fed whatever bytes turn up and reports
+ * date/time matches through a callback.  Lines are scanned in place,
+ * only an incomplete last line is carried over to the next feed. */
+typedef struct dt_scan_s *dt_scan_t;
+
+/**
+ * Match callback, OFF is the offset of the match relative to the start
+ * of the stream (i.e. the first byte ever fed), LEN its length.
+ * A non-0 return value stops scanning, see `dt_scan_feed()'. */
+typedef int(*dt_scan_f)(void *clo, size_t off, size_t len, struct dt_dt_s);
+
+/**
+ * Return a new scanner for formats FMT (of which there are NFMT,
+ * or the ISO defaults if NFMT is 0) in zone ZONE.
+ * Matches are passed to CB along with closure CLO.
+ * FMT must stay around for the lifetime of the scanner, formats that
+ * match across line boundaries (%n) are not supported. */
+extern dt_scan_t
+make_dt_scan(char *const *fmt, size_t nfmt, zif_t zone, dt_scan_f cb, void *clo);
+
+/**
+ * Free resources associated with scanner. */
+extern void free_dt_scan(dt_scan_t);
+
+/**
+ * Feed LEN bytes in BUF to the scanner.
+ * BUF is modified while scanning but restored before returning.
+ * Return 0 on success, -1 if the carry-over buffer could not be grown,
+ * or the first non-0 value returned by the callback in which case the
+ * rest of BUF is skipped. */
+extern int dt_scan_feed(dt_scan_t, char *buf, size_t len);
+
+/**
+ * Scan the carried-over incomplete line, if any, as the stream's last.
+ * Return values as with `dt_scan_feed()'. */
+extern int dt_scan_flush(dt_scan_t);
+
+#endif	/* INCLUDED_dt_scan_h_ */
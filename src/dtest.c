@@ -38,6 +38,7 @@
 #if defined HAVE_CONFIG_H
 # include "config.h"
 #endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -48,12 +49,160 @@
 #include "dt-core.h"
 #include "dt-io.h"
 #include "dt-locale.h"
+#include "prchunk.h"
 
 const char *prog = "dtest";
 
-
+struct prln_ctx_s {
+	char **ifmt;
+	size_t nifmt;
+	zif_t fromz;
+	/* constant right hand side, if any */
+	struct dt_dt_s d2;
+	bool isvalidp;
+	bool selectp;
+	bool quietp;
+};
+
+
 #include "dtest.yucc"
 
+static int
+cmp_res(int res, const yuck_t argi[static 1U])
+{
+/* turn dt_dtcmp() result RES into an exit code according to ARGI */
+	if (res == -2) {
+		/* uncomparable */
+		res = 3;
+	} else if (argi->cmp_flag) {
+		switch (res) {
+		case 0:
+			res = 0;
+			break;
+		case -1:
+			res = 2;
+			break;
+		case 1:
+			res = 1;
+			break;
+		default:
+			res = 3;
+			break;
+		}
+	} else if (argi->eq_flag) {
+		res = res == 0 ? 0 : 1;
+	} else if (argi->ne_flag) {
+		res = res != 0 ? 0 : 1;
+	} else if (argi->lt_flag || argi->ot_flag) {
+		res = res == -1 ? 0 : 1;
+	} else if (argi->le_flag) {
+		res = res == -1 || res == 0 ? 0 : 1;
+	} else if (argi->gt_flag || argi->nt_flag) {
+		res = res == 1 ? 0 : 1;
+	} else if (argi->ge_flag) {
+		res = res == 1 || res == 0 ? 0 : 1;
+	}
+	return res;
+}
+
+static int
+proc_line(
+	struct prln_ctx_s ctx, const yuck_t argi[static 1U],
+	char *line, size_t llen)
+{
+/* evaluate one line of batch input, return the exit code it'd get */
+	static struct dt_dt_s d2;
+	/* last rhs, so we can reuse D2 when it's constant */
+	static char *rhs;
+	static size_t rhsz;
+	struct dt_dt_s d1;
+	char *tab = NULL;
+	int res = 2;
+
+	if (ctx.isvalidp) {
+		return dt_unk_p(dt_io_strpdt(line, ctx.ifmt, ctx.nifmt, ctx.fromz));
+	} else if (!dt_unk_p(ctx.d2)) {
+		/* constant rhs from the command line */
+		d2 = ctx.d2;
+	} else if ((tab = memchr(line, '\t', llen)) == NULL) {
+		if (!ctx.quietp) {
+			error("no DATE/TIME2 in line `%s'", line);
+		}
+		return 2;
+	} else {
+		const char *r2 = tab + 1U;
+		const size_t r2z = line + llen - r2;
+
+		/* terminate lhs */
+		*tab = '\0';
+		if (rhs != NULL && r2z == rhsz && !memcmp(rhs, r2, r2z)) {
+			/* same as last time */
+			;
+		} else if (dt_unk_p(d2 = dt_io_strpdt(
+					    r2, ctx.ifmt, ctx.nifmt, ctx.fromz))) {
+			free(rhs);
+			rhs = NULL;
+			rhsz = 0U;
+			if (!ctx.quietp) {
+				dt_io_warn_strpdt(r2);
+			}
+			goto out;
+		} else {
+			if (r2z > rhsz || rhs == NULL) {
+				free(rhs);
+				rhs = malloc(r2z + 1U);
+			}
+			if (LIKELY(rhs != NULL)) {
+				memcpy(rhs, r2, r2z);
+			}
+			rhsz = r2z;
+		}
+	}
+	if (dt_unk_p(d1 = dt_io_strpdt(line, ctx.ifmt, ctx.nifmt, ctx.fromz))) {
+		if (!ctx.quietp) {
+			dt_io_warn_strpdt(line);
+		}
+		goto out;
+	}
+	res = cmp_res(dt_dtcmp(d1, d2), argi);
+out:
+	if (tab != NULL) {
+		*tab = '\t';
+	}
+	return res;
+}
+
+static int
+proc_batch(struct prln_ctx_s ctx, const yuck_t argi[static 1U])
+{
+	void *pctx;
+
+	/* using the prchunk reader now */
+	if ((pctx = init_prchunk(STDIN_FILENO)) == NULL) {
+		serror("Error: cannot read from stdin");
+		return -1;
+	}
+	while (prchunk_fill(pctx) >= 0) {
+		while (prchunk_haslinep(pctx)) {
+			char *line;
+			size_t llen = prchunk_getline(pctx, &line);
+			int res = proc_line(ctx, argi, line, llen);
+
+			if (!ctx.selectp) {
+				const char buf[] = {(char)('0' + res), '\n'};
+
+				__io_write(buf, sizeof(buf), stdout);
+			} else if (!res) {
+				line[llen] = '\n';
+				__io_write(line, llen + 1U, stdout);
+			}
+		}
+	}
+	free_prchunk(pctx);
+	return 0;
+}
+
+
 int
 main(int argc, char *argv[])
 {
@@ -69,8 +218,15 @@ main(int argc, char *argv[])
 		goto out;
 	}
 
-
-	if (argi->nargs != 1U + !argi->isvalid_flag) {
+	if (argi->select_flag) {
+		argi->batch_flag = 1U;
+	}
+	if (argi->batch_flag && argi->nargs > !argi->isvalid_flag) {
+		yuck_auto_help(argi);
+		res = 2;
+		goto out;
+	} else if (!argi->batch_flag &&
+		   argi->nargs != 1U + !argi->isvalid_flag) {
 		yuck_auto_help(argi);
 		res = 2;
 		goto out;
@@ -88,8 +244,39 @@ main(int argc, char *argv[])
 
 	ifmt = argi->input_format_args;
 	nifmt = argi->input_format_nargs;
+	if (argi->stats_arg) {
+		const char *how = argi->stats_arg != YUCK_OPTARG_NONE
+			? argi->stats_arg : NULL;
 
-	if (argi->isvalid_flag) {
+		if (dt_io_stats_init(how, ifmt, nifmt, 1U) < 0) {
+			res = 1;
+			goto out;
+		}
+	}
+
+	if (argi->batch_flag) {
+		struct prln_ctx_s ctx = {
+			.ifmt = ifmt,
+			.nifmt = nifmt,
+			.fromz = fromz,
+			/* .d2 stays DT_UNK unless given */
+			.isvalidp = argi->isvalid_flag,
+			.selectp = argi->select_flag,
+			.quietp = argi->quiet_flag,
+		};
+
+		if (argi->nargs &&
+		    dt_unk_p(ctx.d2 = dt_io_strpdt(
+				     argi->args[0U], ifmt, nifmt, fromz))) {
+			if (!argi->quiet_flag) {
+				dt_io_warn_strpdt(argi->args[0U]);
+			}
+			res = 2;
+			goto out;
+		}
+		res = proc_batch(ctx, argi) < 0 ? 2 : 0;
+		goto out;
+	} else if (argi->isvalid_flag) {
 		/* check that one date */
 		res = dt_unk_p(dt_io_strpdt(*argi->args, ifmt, nifmt, fromz));
 		goto out;
@@ -110,43 +297,14 @@ main(int argc, char *argv[])
 	}
 
 	/* just do the comparison */
-	if ((res = dt_dtcmp(d1, d2)) == -2) {
-		/* uncomparable */
-		res = 3;
-	} else if (argi->cmp_flag) {
-		switch (res) {
-		case 0:
-			res = 0;
-			break;
-		case -1:
-			res = 2;
-			break;
-		case 1:
-			res = 1;
-			break;
-		default:
-			res = 3;
-			break;
-		}
-	} else if (argi->eq_flag) {
-		res = res == 0 ? 0 : 1;
-	} else if (argi->ne_flag) {
-		res = res != 0 ? 0 : 1;
-	} else if (argi->lt_flag || argi->ot_flag) {
-		res = res == -1 ? 0 : 1;
-	} else if (argi->le_flag) {
-		res = res == -1 || res == 0 ? 0 : 1;
-	} else if (argi->gt_flag || argi->nt_flag) {
-		res = res == 1 ? 0 : 1;
-	} else if (argi->ge_flag) {
-		res = res == 1 || res == 0 ? 0 : 1;
-	}
+	res = cmp_res(dt_dtcmp(d1, d2), argi);
 out:
 	dt_io_clear_zones();
 	if (argi->from_locale_arg) {
 		setilocale(NULL);
 	}
 
+	dt_io_stats_fini();
 	yuck_free(argi);
 	return res;
 }
@@ -54,6 +54,11 @@ struct ztr_s {
 	int32_t offs;
 };
 
+struct zone_s {
+	zif_t zone;
+	const char *name;
+};
+
 /* fwd decld in tzraw.h */
 struct ztrdtl_s {
 	int32_t offs;
@@ -219,6 +224,124 @@ dz_write_prtr(struct zrng_s r, zif_t UNUSED(z), const char *zn)
 	return (bp > gbuf) - 1;
 }
 
+static int
+dz_write_tr(int32_t t, int32_t ooffs, int32_t noffs, const char *zn)
+{
+	char *restrict bp = gbuf;
+	const char *const ep = gbuf + sizeof(gbuf);
+
+	bp += dz_strftr(bp, ep - bp, (struct ztr_s){t, ooffs});
+	bp += xstrlcpy(bp, nindi, ep - bp);
+	bp += dz_strftr(bp, ep - bp, (struct ztr_s){t, noffs});
+
+	/* append name */
+	if (LIKELY(zn != NULL)) {
+		*bp++ = '\t';
+		bp += xstrlcpy(bp, zn, ep - bp);
+	}
+	*bp++ = '\n';
+	__io_write(gbuf, bp - gbuf, stdout);
+	return (bp > gbuf) - 1;
+}
+
+/* cursor into a zone's transitions, for merging */
+struct zcur_s {
+	int i;
+	int32_t t;
+};
+
+static inline bool
+zcur_less(const struct zcur_s *c, size_t j, size_t k)
+{
+/* by transition time, ties go to the zone given first */
+	if (c[j].t != c[k].t) {
+		return c[j].t < c[k].t;
+	}
+	return j < k;
+}
+
+static void
+zcur_sift(const struct zcur_s *c, size_t *restrict h, size_t nh, size_t i)
+{
+/* sift element I of heap H down */
+	for (size_t k; (k = 2U * i + 1U) < nh; i = k) {
+		if (k + 1U < nh && zcur_less(c, h[k + 1U], h[k])) {
+			k++;
+		}
+		if (!zcur_less(c, h[k], h[i])) {
+			break;
+		}
+		with (size_t tmp = h[i]) {
+			h[i] = h[k];
+			h[k] = tmp;
+		}
+	}
+	return;
+}
+
+static int
+dz_write_range(const struct zone_s z[], size_t nz, int32_t from, int32_t till)
+{
+/* write all transitions in [FROM, TILL] of all NZ zones Z,
+ * every zone's transitions are walked linearly, once, and the
+ * NZ streams are merged through a heap on transition time */
+	struct zcur_s *cur;
+	size_t *h;
+	size_t nh = 0U;
+
+	if (UNLIKELY((cur = calloc(nz, sizeof(*cur))) == NULL)) {
+		return -1;
+	} else if (UNLIKELY((h = calloc(nz, sizeof(*h))) == NULL)) {
+		free(cur);
+		return -1;
+	}
+	/* position cursors on the first transition at or after FROM */
+	for (size_t j = 0U; j < nz; j++) {
+		const int ntr = z[j].zone ? (int)zif_ntrans(z[j].zone) : 0;
+		int i;
+
+		if (UNLIKELY(!ntr)) {
+			/* no transitions at all */
+			continue;
+		}
+		i = zif_find_trans(z[j].zone, from);
+		for (i = i > 0 ? i : 0;
+		     i < ntr && zif_trans(z[j].zone, i) < from; i++);
+		if (i >= ntr || zif_trans(z[j].zone, i) > till) {
+			/* nothing in range */
+			continue;
+		}
+		cur[j] = (struct zcur_s){i, zif_trans(z[j].zone, i)};
+		h[nh++] = j;
+	}
+	/* heapify */
+	for (size_t k = nh / 2U; k-- > 0U;) {
+		zcur_sift(cur, h, nh, k);
+	}
+	while (nh > 0U) {
+		const size_t best = h[0U];
+		const zif_t zb = z[best].zone;
+		const int i = cur[best].i;
+		/* offset before (type of transition -1 is type 0) */
+		const int32_t oo = zif_trdtl(zb, i - 1).offs;
+		const int32_t no = zif_trdtl(zb, i).offs;
+
+		dz_write_tr(cur[best].t, oo, no, z[best].name);
+		if (i + 1 < (int)zif_ntrans(zb) &&
+		    (cur[best].t = zif_trans(zb, i + 1)) <= till) {
+			cur[best].i = i + 1;
+		} else {
+			/* exhausted, replace by the last one */
+			h[0U] = h[--nh];
+		}
+		zcur_sift(cur, h, nh, 0U);
+	}
+	free(h);
+	free(cur);
+	return 0;
+}
+
+
 
 #include "dzone.yucc"
 
@@ -231,15 +354,13 @@ main(int argc, char *argv[])
 	char **fmt;
 	size_t nfmt;
 	/* all them zones to consider */
-	struct {
-		zif_t zone;
-		const char *name;
-	} *z = NULL;
+	struct zone_s *z = NULL;
 	size_t nz = 0U;
 	/* all them datetimes to consider */
 	struct dt_dt_s *d = NULL;
 	size_t nd = 0U;
 	bool trnsp = false;
+	bool rangep = false;
 
 	if (yuck_parse(argi, argc, argv)) {
 		rc = 1;
@@ -261,6 +382,9 @@ main(int argc, char *argv[])
 	if (argi->next_flag || argi->prev_flag) {
 		trnsp = true;
 	}
+	if (argi->range_flag) {
+		rangep = trnsp = true;
+	}
 	if (argi->base_arg) {
 		struct dt_dt_s base = dt_strpdt(argi->base_arg, NULL, NULL);
 		dt_set_base(base);
@@ -312,12 +436,41 @@ nor a date/time corresponding to the given input formats", inp);
 	}
 	if (nd == 0U && !trnsp) {
 		d[nd++] = dt_datetime((dt_dttyp_t)DT_YMD);
-	} else if (nd == 0U) {
+	} else if (nd == 0U && !rangep) {
 		d[nd++] = dt_datetime((dt_dttyp_t)DT_SEXY);
 	}
 
 	/* just go through them all now */
-	if (LIKELY(!trnsp)) {
+	if (UNLIKELY(rangep)) {
+		/* span the earliest to the latest date/time */
+		dt_ssexy_t from = INT32_MAX;
+		dt_ssexy_t till = INT32_MIN;
+
+		if (nd < 2U) {
+			error("--range needs a FROM and a TILL DATE/TIME");
+			rc = 1;
+			goto out;
+		}
+		for (size_t i = 0U; i < nd; i++) {
+			/* dt_dtconv() would wrap 32 bits, go wide */
+			const dt_ssexy_t sx = d[i].typ == DT_SEXY
+				? d[i].sxepoch : dt_to_unix_epoch(d[i]);
+
+			if (sx < from) {
+				from = sx;
+			}
+			if (sx > till) {
+				till = sx;
+			}
+		}
+		/* zoneinfo is 32 bits only, clamp to that */
+		from = from > INT32_MIN ? from : INT32_MIN;
+		till = till < INT32_MAX ? till : INT32_MAX;
+		if (dz_write_range(z, nz, (int32_t)from, (int32_t)till) < 0) {
+			error("failed to allocate space for transition cursors");
+			rc = 1;
+		}
+	} else if (LIKELY(!trnsp)) {
 		for (size_t i = 0U; !trnsp && i < nd; i++) {
 			for (size_t j = 0U; j < nz; j++) {
 				dz_io_write(d[i], z[j].zone, z[j].name);
@@ -57,9 +57,20 @@
 
 #include "nifty.h"
 #include "prchunk.h"
-
-#define MAX_NLINES	(16384)
-#define MAX_LLEN	(1024)
+#include "dt-io-stats.h"
+
+/* initial sizes, all of these grow geometrically on demand */
+#define INI_NLINES	(16384U)
+#define INI_LLEN	(1024U)
+#define INI_BSZ		(INI_NLINES * INI_LLEN)
+/* read sizes, starting small for interactive use */
+#define MIN_RDSZ	(65536U)
+#define MAX_RDSZ	(4U * 1024U * 1024U)
+/* rechunker supports this many columns per line */
+#define MAX_NCOLS	(512U)
+#define COL_NONE	((off32_t)-1)
+/* have the kernel read this many bytes ahead of us */
+#define RA_WINDOW	(4U * 1024U * 1024U)
 
 #if !defined MAP_ANONYMOUS && defined MAP_ANON
 # define MAP_ANONYMOUS	(MAP_ANON)
@@ -72,13 +83,15 @@
 #endif	/* __INTEL_COMPILER */
 
 typedef uint32_t off32_t;
-typedef uint16_t off16_t;
 
 struct prch_ctx_s {
 	/* file descriptor */
 	int fd;
-	/* buffer */
+	/* buffer and its size */
 	char *buf;
+	size_t bsz;
+	/* current read size */
+	size_t rdsz;
 	/* number of lines in the buffer */
 	uint32_t tot_lno;
 	/* number of columns per line */
@@ -87,13 +100,72 @@ struct prch_ctx_s {
 	size_t bno;
 	/* last known offset */
 	size_t off;
-	/* offsets */
-	off32_t loff[MAX_NLINES];
+	/* offsets, and how many of them fit */
+	off32_t *loff;
+	size_t nloff;
 	off32_t cur_lno;
-	/* delimiter offsets */
-	off16_t *soff;
+	/* delimiter offsets, and how many of them fit */
+	off32_t *soff;
+	size_t nsoff;
+	/* file offset of the next read, or -1 if FD isn't seekable */
+	off_t fpos;
+	/* file offset up to which read-ahead has been requested */
+	off_t ra;
 };
 
+
+/* memory management */
+static void*
+remap(void *old, size_t olen, size_t nlen)
+{
+/* like mremap(2) but portable, OLD may be NULL */
+#define MAP_MEM		(MAP_ANON | MAP_PRIVATE)
+#define PROT_MEM	(PROT_READ | PROT_WRITE)
+	void *new = mmap(NULL, nlen, PROT_MEM, MAP_MEM, -1, 0);
+
+	if (UNLIKELY(new == MAP_FAILED)) {
+		return NULL;
+	} else if (old != NULL) {
+		memcpy(new, old, olen < nlen ? olen : nlen);
+		munmap(old, olen);
+	}
+#undef MAP_MEM
+#undef PROT_MEM
+	return new;
+}
+
+static int
+grow_buf(prch_ctx_t ctx)
+{
+	const size_t nsz = ctx->bsz * 2U;
+	char *nu;
+
+	if (UNLIKELY(nsz > (size_t)INT32_MAX)) {
+		/* loff can't address that */
+		return -1;
+	} else if (UNLIKELY((nu = remap(ctx->buf, ctx->bsz, nsz)) == NULL)) {
+		return -1;
+	}
+	ctx->buf = nu;
+	ctx->bsz = nsz;
+	return 0;
+}
+
+static int
+grow_loff(prch_ctx_t ctx)
+{
+	const size_t nsz = ctx->nloff * 2U;
+	off32_t *nu;
+
+	nu = remap(ctx->loff, ctx->nloff * sizeof(*nu), nsz * sizeof(*nu));
+	if (UNLIKELY(nu == NULL)) {
+		return -1;
+	}
+	ctx->loff = nu;
+	ctx->nloff = nsz;
+	return 0;
+}
+
 
 /* error() impl */
 static void
@@ -154,15 +226,40 @@ get_llen(prch_ctx_t ctx, uint32_t lno)
 		get_loff(ctx, lno - 1) - 1;
 }
 
-
+static inline void
+read_ahead(prch_ctx_t ctx)
+{
+/* ask for the next window while we're still halfway through the current
+ * one, the kernel fills the page cache asynchronously so that parsing of
+ * this chunk and i/o for the next one overlap */
+#if defined POSIX_FADV_WILLNEED
+	if (UNLIKELY(ctx->fpos < 0)) {
+		/* pipe or tty */
+		return;
+	} else if (LIKELY(ctx->fpos + (off_t)(RA_WINDOW / 2U) < ctx->ra)) {
+		/* still plenty in flight */
+		return;
+	} else if (posix_fadvise(ctx->fd, ctx->ra, RA_WINDOW,
+				 POSIX_FADV_WILLNEED)) {
+		/* don't bother again */
+		ctx->fpos = -1;
+		return;
+	}
+	ctx->ra += RA_WINDOW;
+#else  /* !POSIX_FADV_WILLNEED */
+	(void)ctx;
+#endif	/* POSIX_FADV_WILLNEED */
+	return;
+}
+
+
 /* internal operations */
-FDEFU int
-prchunk_fill(prch_ctx_t ctx)
+static int
+__fill(prch_ctx_t ctx)
 {
 /* this is a coroutine consisting of a line counter yielding the number of
  * lines read so far and a reader yielding a buffer fill and the number of
  * bytes read */
-#define CHUNK_SIZE	(4096)
 #define YIELD(x)	goto yield##x
 	char *off = ctx->buf + 0;
 	char *bno = ctx->buf + ctx->bno;
@@ -170,18 +267,16 @@ prchunk_fill(prch_ctx_t ctx)
 
 	/* initial work, reset the line counters et al */
 	ctx->tot_lno = 0;
-	/* we just memcpy() the left over stuff to the front and restart
+	/* we just memmove() the left over stuff to the front and restart
 	 * from there, someone left us a note in __ctx with the left
-	 * over offset */
-	/* normally we'd use memmove() but we know there's little chance
-	 * for overlapping regions */
+	 * over offset, long lines might well overlap */
 	if (UNLIKELY(ctx->bno == 0)) {
 		/* do nothing */
 		;
 	} else if (LIKELY(ctx->bno > ctx->off)) {
 		size_t rsz = ctx->bno - ctx->off;
 		/* move the top RSZ bytes to the beginning */
-		memcpy(ctx->buf, ctx->buf + ctx->off, rsz);
+		memmove(ctx->buf, ctx->buf + ctx->off, rsz);
 		ctx->bno = rsz;
 		bno = ctx->buf + rsz;
 	} else if (UNLIKELY(ctx->bno == ctx->off)) {
@@ -194,26 +289,50 @@ prchunk_fill(prch_ctx_t ctx)
 	}
 
 yield1:
-	/* read CHUNK_SIZE bytes */
-	bno += (nrd = read(ctx->fd, bno, CHUNK_SIZE));
-	/* if we came from yield2 then off == __ctx->bno, and if we
-	 * read 0 or less bytes then off >= __ctx->bno + nrd, so we
-	 * can simply use that compact expression if the buffer has no
-	 * more input.
-	 * On the contrary if we came from the outside, i.e. fill_buffer()
-	 * has been called, then off would be 0 and __ctx->bno would be
-	 * the buffer filled so far, if no more bytes could be read then
-	 * we'd proceed processing them (off < __ctx->bno + nrd */
-	if (UNLIKELY(!nrd && off < bno && ctx->cur_lno <= ctx->tot_lno)) {
-		/* last line then, unyielded :| */
-		set_loff(ctx, 0, bno - ctx->buf);
-		YIELD(4);
-	} else if (UNLIKELY(nrd <= 0 && off == ctx->buf)) {
+	/* make sure there's room for another read plus a \0 */
+	if (UNLIKELY((size_t)(ctx->buf + ctx->bsz - bno) <= ctx->rdsz)) {
+		if (ctx->tot_lno) {
+			/* hand out what we've got first */
+			YIELD(3);
+		}
+		/* no complete line in the whole buffer, grow it */
+		with (size_t o = off - ctx->buf, b = bno - ctx->buf) {
+			if (UNLIKELY(grow_buf(ctx) < 0)) {
+				error(errno, "cannot grow line buffer");
+				return -1;
+			}
+			off = ctx->buf + o;
+			bno = ctx->buf + b;
+		}
+		YIELD(1);
+	}
+	/* keep the read-ahead window ahead of us */
+	read_ahead(ctx);
+	/* read RDSZ bytes */
+	if (LIKELY((nrd = read(ctx->fd, bno, ctx->rdsz)) > 0)) {
+		bno += nrd;
+		if (UNLIKELY(dt_io_stats != NULL)) {
+			dt_io_stats->nrd += nrd;
+		}
+		if (ctx->fpos >= 0) {
+			ctx->fpos += nrd;
+		}
+		/* whenever we get what we asked for, ask for more next time */
+		if ((size_t)nrd == ctx->rdsz && ctx->rdsz < MAX_RDSZ &&
+		    ctx->rdsz * 4U <= ctx->bsz) {
+			ctx->rdsz *= 2U;
+		}
+	}
+	/* if we came from yield2 then everything up to OFF has been
+	 * handed out as lines, if there's more (or we came from the
+	 * outside with left overs) go and find lines, at the end of the
+	 * file this includes the unterminated last line */
+	if (LIKELY(off < bno)) {
+		YIELD(2);
+	} else if (UNLIKELY(nrd <= 0 && !ctx->tot_lno)) {
 		/* special case, we worked our arses off and nothing's
 		 * in the pipe line so just fuck off here */
 		return -1;
-	} else if (LIKELY(off < bno || off == ctx->buf)) {
-		YIELD(2);
 	}
 	/* proceed to exit */
 	YIELD(3);
@@ -225,79 +344,158 @@ yield2:
 			if (LIKELY(nrd > 0)) {
 				break;
 			}
-			/* fucking idiots didnt conclude with a \n */
-			error(0, "ID:10T error");
+			/* fucking idiots didnt conclude with a \n,
+			 * there's always room for the \0 though */
 			p = bno;
 		}
 		/* massage our status structures */
+		if (UNLIKELY(ctx->tot_lno >= ctx->nloff) &&
+		    UNLIKELY(grow_loff(ctx) < 0)) {
+			/* yield what we've got then */
+			YIELD(3);
+		}
 		set_loff(ctx, ctx->tot_lno, p - ctx->buf);
-		if (UNLIKELY(p[-1] == '\r')) {
+		if (UNLIKELY(p > off && p[-1] == '\r')) {
 			/* oh god, when is this nightmare gonna end */
 			p[-1] = '\0';
 			set_lftermd(ctx, ctx->tot_lno);
 		}
 		*p = '\0';
 		off = ++p;
-		/* count it as line and check if we need more */
-		if (++ctx->tot_lno >= MAX_NLINES) {
-			YIELD(3);
-		}
+		/* count it as line */
+		ctx->tot_lno++;
+	}
+	if (UNLIKELY(nrd <= 0)) {
+		/* that was the last of it */
+		YIELD(3);
 	}
 	YIELD(1);
 yield3:
 	/* need clean up, something like unread(),
 	 * in particular leave a note in __ctx with the left over offset */
 	ctx->cur_lno = 0;
-yield4:
 	ctx->off = off - ctx->buf;
 	ctx->bno = bno - ctx->buf;
 #undef YIELD
-#undef CHUNK_SIZE
 	return 0;
 }
 
-
-/* public operations */
-FDEFU prch_ctx_t
-init_prchunk(int fd)
+FDEFU int
+prchunk_fill(prch_ctx_t ctx)
 {
-#define MAP_MEM		(MAP_ANON | MAP_PRIVATE)
-#define PROT_MEM	(PROT_READ | PROT_WRITE)
-#define MAP_LEN		(MAX_NLINES * MAX_LLEN)
-	static struct prch_ctx_s __ctx;
+	uint64_t t = dt_io_stats_tick();
+	int rc = __fill(ctx);
 
-	__ctx.buf = mmap(NULL, MAP_LEN, PROT_MEM, MAP_MEM, -1, 0);
-	if (__ctx.buf == MAP_FAILED) {
-		return NULL;
+	if (UNLIKELY(dt_io_stats != NULL)) {
+		if (rc >= 0) {
+			dt_io_stats->nln += ctx->tot_lno;
+		}
+		dt_io_stats_lap(DT_IO_STG_READ, &t);
+	}
+	return rc;
+}
+
+
+static int
+init_ctx(prch_ctx_t ctx, int fd, size_t ibsz)
+{
+	/* start afresh, buffers are kept from earlier files */
+	ctx->tot_lno = ctx->cur_lno = 0U;
+	ctx->bno = ctx->off = 0U;
+	ctx->rdsz = MIN_RDSZ;
+	if (ctx->buf == NULL) {
+		if ((ctx->buf = remap(NULL, 0U, ibsz)) == NULL) {
+			return -1;
+		}
+		ctx->bsz = ibsz;
 	}
+	if (ctx->loff == NULL) {
+		const size_t z = INI_NLINES * sizeof(*ctx->loff);
 
-	/* bit of space for the rechunker */
-	__ctx.soff = mmap(NULL, MAP_LEN, PROT_MEM, MAP_MEM, -1, 0);
-	if (__ctx.soff == MAP_FAILED) {
-		return NULL;
+		if ((ctx->loff = remap(NULL, 0U, z)) == NULL) {
+			return -1;
+		}
+		ctx->nloff = INI_NLINES;
 	}
 
-	if ((__ctx.fd = fd) > STDIN_FILENO) {
+	if ((ctx->fd = fd) > STDIN_FILENO) {
 #if defined POSIX_FADV_SEQUENTIAL
 		/* give advice about our read pattern */
 		int rc = posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
 
 		if (UNLIKELY(rc < 0)) {
-			munmap(__ctx.soff, MAP_LEN);
-			return NULL;
+			return -1;
 		}
 #endif	/* POSIX_FADV_SEQUENTIAL */
 	}
+	/* stdin might be a regular file too, read-ahead only works there */
+	ctx->ra = ctx->fpos = lseek(fd, 0, SEEK_CUR);
+	return 0;
+}
+
+static void
+fini_ctx(prch_ctx_t ctx)
+{
+	if (LIKELY(ctx->buf != NULL)) {
+		munmap(ctx->buf, ctx->bsz);
+		ctx->buf = NULL;
+		ctx->bsz = 0U;
+	}
+	if (LIKELY(ctx->loff != NULL)) {
+		munmap(ctx->loff, ctx->nloff * sizeof(*ctx->loff));
+		ctx->loff = NULL;
+		ctx->nloff = 0U;
+	}
+	if (ctx->soff != NULL) {
+		munmap(ctx->soff, ctx->nsoff * sizeof(*ctx->soff));
+		ctx->soff = NULL;
+		ctx->nsoff = 0U;
+	}
+	return;
+}
+
+
+/* public operations */
+FDEFU prch_ctx_t
+init_prchunk(int fd)
+{
+	static struct prch_ctx_s __ctx;
+
+	if (UNLIKELY(init_ctx(&__ctx, fd, INI_BSZ) < 0)) {
+		return NULL;
+	}
 	return &__ctx;
 }
 
 FDEFU void
 free_prchunk(prch_ctx_t ctx)
 {
-	if (LIKELY(ctx->buf != NULL)) {
-		munmap(ctx->buf, MAP_LEN);
-		ctx->buf = NULL;
+	fini_ctx(ctx);
+	return;
+}
+
+FDEFU prch_ctx_t
+init_prchunk_r(int fd)
+{
+/* like init_prchunk() but with a context of its own, for readers that
+ * keep many files open at once, buffers start small and grow */
+	prch_ctx_t ctx;
+
+	if (UNLIKELY((ctx = calloc(1U, sizeof(*ctx))) == NULL)) {
+		return NULL;
+	} else if (UNLIKELY(init_ctx(ctx, fd, MIN_RDSZ * 4U) < 0)) {
+		fini_ctx(ctx);
+		free(ctx);
+		return NULL;
 	}
+	return ctx;
+}
+
+FDEFU void
+free_prchunk_r(prch_ctx_t ctx)
+{
+	fini_ctx(ctx);
+	free(ctx);
 	return;
 }
 
@@ -340,8 +538,7 @@ prchunk_reset(prch_ctx_t ctx)
 FDEFU int
 prchunk_haslinep(prch_ctx_t ctx)
 {
-/* the second condition is to allow unterminated last lines */
-	return ctx->cur_lno < ctx->tot_lno || ctx->cur_lno == 0U;
+	return ctx->cur_lno < ctx->tot_lno;
 }
 
 
@@ -361,11 +558,11 @@ prchunk_get_ncols(prch_ctx_t ctx)
 static inline void
 set_col_off(prch_ctx_t ctx, size_t lno, size_t cno, size_t off)
 {
-	ctx->soff[lno * prchunk_get_ncols(ctx) + cno] = (off16_t)off;
+	ctx->soff[lno * prchunk_get_ncols(ctx) + cno] = (off32_t)off;
 	return;
 }
 
-static inline off16_t
+static inline off32_t
 get_col_off(prch_ctx_t ctx, size_t lno, size_t cno)
 {
 	return ctx->soff[lno * prchunk_get_ncols(ctx) + cno];
@@ -373,46 +570,76 @@ get_col_off(prch_ctx_t ctx, size_t lno, size_t cno)
 
 /* rechunker, chop the lines into smaller bits
  * Strategy is to go over all lines in the current chunk and
- * memchr() for the delimiter DELIM.
+ * memchr() for the delimiter DELIM, at most NCOLS - 1 times per line,
+ * i.e. the last column extends to the end of the line.
  * Store the offsets into __ctx->soff and bugger off leaving a \0
- * where the delimiter was. */
-FDEFU void
+ * where the delimiter was.  Columns a line doesn't have are marked
+ * with COL_NONE.
+ * NCOLS is an upper bound, a chunk whose lines are all narrower is
+ * chopped into as many columns as its widest line has. */
+FDEFU int
 prchunk_rechunk(prch_ctx_t ctx, char dlm, int ncols)
 {
 /* very naive implementation, we prefer prchunk_rechunk_by_dstfld()
  * where a distance histogram demarks possible places */
-	size_t lno = 0;
-	size_t cno = 0;
-	char *line;
-	char *off;
-	char *p;
-	char *bno = ctx->buf + ctx->off;
-	size_t rsz;
+	const size_t nlno = ctx->tot_lno;
 
+	if (UNLIKELY(ncols <= 0 || (size_t)ncols > MAX_NCOLS)) {
+		return -1;
+	}
+	with (int wide = 1) {
+		/* find the widest line, as far as NCOLS goes */
+		for (size_t lno = 0; lno < nlno && wide < ncols; lno++) {
+			char *line;
+			const size_t llen = prchunk_getlineno(ctx, &line, lno);
+			const char *const eol = line + llen;
+			int cno = 1;
+
+			for (const char *p = line;
+			     cno < ncols && (p = memchr(p, dlm, eol - p)) != NULL;
+			     p++, cno++);
+			if (cno > wide) {
+				wide = cno;
+			}
+		}
+		ncols = wide;
+	}
+	if (UNLIKELY(nlno * ncols > ctx->nsoff)) {
+		/* grow geometrically */
+		size_t nsz = ctx->nsoff ?: INI_NLINES;
+		off32_t *nu;
+
+		while ((nsz *= 2U) < nlno * ncols);
+		nu = remap(ctx->soff,
+			   ctx->nsoff * sizeof(*nu), nsz * sizeof(*nu));
+		if (UNLIKELY(nu == NULL)) {
+			return -1;
+		}
+		ctx->soff = nu;
+		ctx->nsoff = nsz;
+	}
 	set_ncols(ctx, ncols);
-	off = line = ctx->buf;
-	rsz = bno - off;
-	while ((p = memchr(off, dlm, rsz)) != NULL) {
-		size_t co;
-		size_t llen = get_llen(ctx, lno);
-		while ((co = p - line) > llen) {
-			/* last column offset equals the length of the line */
-			set_col_off(ctx, lno, cno, llen);
-			/* get the new line */
-			line = ctx->buf + get_loff(ctx, lno++) + 1;
-			cno = 0;
+	for (size_t lno = 0; lno < nlno; lno++) {
+		char *line;
+		const size_t llen = prchunk_getlineno(ctx, &line, lno);
+		const char *const eol = line + llen;
+		int cno = 0;
+
+		for (char *p = line;
+		     cno < ncols - 1 && (p = memchr(p, dlm, eol - p)) != NULL;
+		     p++) {
+			/* store the offset of the column within the line */
+			set_col_off(ctx, lno, cno++, p - line);
+			*p = '\0';
+		}
+		/* last column offset equals the length of the line */
+		set_col_off(ctx, lno, cno++, llen);
+		/* and the rest is missing */
+		for (; cno < ncols; cno++) {
+			set_col_off(ctx, lno, cno, COL_NONE);
 		}
-		/* store the offset of the column within the line */
-		set_col_off(ctx, lno, cno++, co);
-		/* prepare the counters for the next round */
-		*p = '\0';
-		off = ++p;
-		rsz = bno - off;
 	}
-	/* last column offset equals the length of the line */
-	rsz = get_llen(ctx, lno);
-	set_col_off(ctx, lno, cno, rsz);
-	return;
+	return 0;
 }
 
 FDEFU size_t
@@ -424,6 +651,11 @@ prchunk_getcolno(prch_ctx_t ctx, char **p, int lno, int cno)
 		*p = NULL;
 		return 0;
 	}
+	if (UNLIKELY(get_col_off(ctx, lno, cno) == COL_NONE)) {
+		/* line's too short */
+		*p = NULL;
+		return 0;
+	}
 	(void)prchunk_getlineno(ctx, p, lno);
 	if (UNLIKELY(cno == 0)) {
 		return get_col_off(ctx, lno, 0);
@@ -52,6 +52,10 @@ typedef struct prch_ctx_s *prch_ctx_t;
 FDECL prch_ctx_t init_prchunk(int fd);
 FDECL void free_prchunk(prch_ctx_t);
 
+/* reentrant versions, one context per call */
+FDECL prch_ctx_t init_prchunk_r(int fd);
+FDECL void free_prchunk_r(prch_ctx_t);
+
 FDECL int prchunk_fill(prch_ctx_t ctx);
 
 FDECL size_t prchunk_get_nlines(prch_ctx_t);
@@ -62,7 +66,7 @@ FDECL size_t prchunk_getline(prch_ctx_t ctx, char **p);
 FDECL void prchunk_reset(prch_ctx_t ctx);
 FDECL int prchunk_haslinep(prch_ctx_t ctx);
 
-FDECL void prchunk_rechunk(prch_ctx_t ctx, char delim, int ncols);
+FDECL int prchunk_rechunk(prch_ctx_t ctx, char delim, int ncols);
 FDECL size_t prchunk_getcolno(prch_ctx_t ctx, char **p, int lno, int cno);
 
 #endif	/* INCLUDED_prchunk_h_ */
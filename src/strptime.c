@@ -56,9 +56,10 @@ const char *prog = "strptime";
 static int
 pars_line(struct tm *tm, const char *const *fmt, size_t nfmt, const char *line)
 {
+/* return the index of the format that matched, or -1 */
 	for (size_t i = 0; i < nfmt; i++) {
 		if (fmt[i] && strptime(line, fmt[i], tm) != NULL) {
-			return 0;
+			return (int)i;
 		}
 	}
 	return -1;
@@ -68,8 +69,11 @@ static void
 prnt_line(const char *ofmt, struct tm *tm)
 {
 	char res[256];
-	strftime(res, sizeof(res), ofmt, tm);
-	fputs(res, stdout);
+	uint64_t t = dt_io_stats_tick();
+	size_t n = strftime(res, sizeof(res), ofmt, tm);
+
+	dt_io_stats_lap(DT_IO_STG_FMT, &t);
+	__io_write(res, n, stdout);
 	return;
 }
 
@@ -80,9 +84,20 @@ proc_line(
 	int quietp)
 {
 	struct tm tm = {0};
+	uint64_t t = dt_io_stats_tick();
+	int fi = pars_line(&tm, fmt, nfmt, ln);
 	int rc = 0;
 
-	if (pars_line(&tm, fmt, nfmt, ln) < 0) {
+	if (UNLIKELY(dt_io_stats != NULL)) {
+		if (fi < 0) {
+			dt_io_stats->nfail++;
+		} else {
+			dt_io_stats->nok++;
+			dt_io_stats_fmt(fmt[fi]);
+		}
+		dt_io_stats_lap(DT_IO_STG_PARSE, &t);
+	}
+	if (fi < 0) {
 		if (!quietp) {
 			dt_io_warn_strpdt(ln);
 			rc = 2;
@@ -160,6 +175,15 @@ main(int argc, char *argv[])
 		input = argi->args;
 		ninput = argi->nargs;
 	}
+	if (argi->stats_arg) {
+		const char *how = argi->stats_arg != YUCK_OPTARG_NONE
+			? argi->stats_arg : NULL;
+
+		if (dt_io_stats_init(how, infmt, ninfmt, 1U) < 0) {
+			rc = 1;
+			goto out;
+		}
+	}
 	/* get quiet predicate */
 	quietp = argi->quiet_flag;
 
@@ -189,6 +213,7 @@ main(int argc, char *argv[])
 	}
 
 out:
+	dt_io_stats_fini();
 	yuck_free(argi);
 	return rc;
 }
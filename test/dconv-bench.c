@@ -0,0 +1,61 @@
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include "date-core.h"
+#include "nifty.h"
+
+static const dt_dtyp_t typs[] = {
+	DT_YMD, DT_YMCW, DT_YWD, DT_YD, DT_DAISY, DT_JDN, DT_LDN,
+};
+
+static double
+now(void)
+{
+	struct timespec tsp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tsp);
+	return (double)tsp.tv_sec + (double)tsp.tv_nsec * 1e-9;
+}
+
+int
+main(int argc, char *argv[])
+{
+	/* number of rounds, a round is every day from 1917 to 2099 */
+	const size_t nrounds = argc > 1 ? strtoul(argv[1], NULL, 10) : 1U;
+	const size_t n = 66474U;
+	struct dt_d_s *src = calloc(n, sizeof(*src));
+	struct dt_d_s *res = calloc(n, sizeof(*res));
+
+	for (size_t i = 0U; i < countof(typs); i++) {
+		/* all days since 1917-01-01 in source type */
+		for (size_t k = 0U; k < n; k++) {
+			struct dt_d_s d = {DT_DAISY, .daisy = k + 1U};
+			src[k] = dt_dconv(typs[i], d);
+		}
+		for (size_t j = 0U; j < countof(typs); j++) {
+			double t0, t1, t2;
+
+			t0 = now();
+			for (size_t r = 0U; r < nrounds; r++) {
+				for (size_t k = 0U; k < n; k++) {
+					res[k] = dt_dconv(typs[j], src[k]);
+				}
+			}
+			t1 = now();
+			for (size_t r = 0U; r < nrounds; r++) {
+				dt_dconv_n(typs[j], res, src, n);
+			}
+			t2 = now();
+
+			printf("%u -> %u\tdt_dconv() %.3fs\tdt_dconv_n() %.3fs\n",
+			       (unsigned int)typs[i], (unsigned int)typs[j],
+			       t1 - t0, t2 - t1);
+		}
+	}
+	free(src);
+	free(res);
+	return 0;
+}
@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dt-scan.h"
+#include "nifty.h"
+
+/* dt-io wants this */
+const char *prog = "dt-scan-1";
+
+struct clo_s {
+	char *out;
+	size_t olen;
+	size_t osz;
+};
+
+static int
+cb(void *clo, size_t off, size_t len, struct dt_dt_s d)
+{
+	struct clo_s *c = clo;
+	char buf[256U];
+	int n;
+
+	n = snprintf(buf, sizeof(buf), "%zu\t%zu\t", off, len);
+	n += dt_strfdt(buf + n, sizeof(buf) - n, NULL, d);
+	buf[n++] = '\n';
+	if (c->olen + n >= c->osz) {
+		c->out = realloc(c->out, c->osz = (c->olen + n) * 2U);
+	}
+	memcpy(c->out + c->olen, buf, n);
+	c->olen += n;
+	return 0;
+}
+
+static int
+scan(struct clo_s *c, char *const *fmt, size_t nfmt, char *str, size_t len, size_t chunk)
+{
+	dt_scan_t s = make_dt_scan(fmt, nfmt, NULL, cb, c);
+
+	if (s == NULL) {
+		return -1;
+	}
+	c->olen = 0U;
+	for (size_t i = 0U; i < len; i += chunk) {
+		dt_scan_feed(s, str + i, i + chunk < len ? chunk : len - i);
+	}
+	dt_scan_flush(s);
+	free_dt_scan(s);
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	static char str[65536U];
+	struct clo_s ref = {};
+	struct clo_s tst = {};
+	size_t len = fread(str, 1, sizeof(str), stdin);
+	int res = 0;
+
+	/* the whole lot in one go */
+	if (scan(&ref, argv + 1, argc - 1, str, len, len ?: 1U) < 0) {
+		fputs("cannot create scanner\n", stderr);
+		return 1;
+	}
+	fwrite(ref.out, 1, ref.olen, stdout);
+
+	/* must be the same no matter how it's fragmented */
+	for (size_t chunk = 1U; chunk < 8U; chunk++) {
+		scan(&tst, argv + 1, argc - 1, str, len, chunk);
+		if (tst.olen != ref.olen || memcmp(tst.out, ref.out, ref.olen)) {
+			fprintf(stderr, "results differ for %zu-byte chunks\n", chunk);
+			res = 1;
+		}
+	}
+	/* make sure the input is untouched */
+	if (memchr(str, '\0', len) != NULL) {
+		fputs("input has been altered\n", stderr);
+		res = 1;
+	}
+	free(ref.out);
+	free(tst.out);
+	return res;
+}
@@ -0,0 +1,64 @@
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "date-core.h"
+#include "nifty.h"
+
+static const dt_dtyp_t typs[] = {
+	DT_YMD, DT_YMCW, DT_YWD, DT_YD, DT_DAISY, DT_JDN, DT_LDN,
+};
+
+int
+main(void)
+{
+	/* every day from 1917 to 2099 */
+	const size_t n = 66474U;
+	struct dt_d_s *src = calloc(n, sizeof(*src));
+	struct dt_d_s *ref = calloc(n, sizeof(*ref));
+	struct dt_d_s *res = calloc(n, sizeof(*res));
+	int rc = 0;
+
+	if (src == NULL || ref == NULL || res == NULL) {
+		rc = 1;
+		goto out;
+	}
+	/* dt_dconv_n() must agree with dt_dconv() for every pair */
+	for (size_t i = 0U; i < countof(typs); i++) {
+		for (size_t k = 0U; k < n; k++) {
+			struct dt_d_s d = {DT_DAISY, .daisy = k + 1U};
+			src[k] = dt_dconv(typs[i], d);
+		}
+		for (size_t j = 0U; j < countof(typs); j++) {
+			for (size_t k = 0U; k < n; k++) {
+				ref[k] = dt_dconv(typs[j], src[k]);
+			}
+			dt_dconv_n(typs[j], res, src, n);
+
+			if (memcmp(ref, res, n * sizeof(*res))) {
+				fprintf(stderr, "  %u -> %u DIFFERS\n",
+					(unsigned int)typs[i],
+					(unsigned int)typs[j]);
+				rc = 1;
+			}
+		}
+	}
+	/* in-place conversion of a mixed array */
+	for (size_t k = 0U; k < n; k++) {
+		struct dt_d_s d = {DT_DAISY, .daisy = k + 1U};
+		src[k] = dt_dconv(typs[k % countof(typs)], d);
+		ref[k] = dt_dconv(DT_YWD, src[k]);
+	}
+	dt_dconv_n(DT_YWD, src, src, n);
+	if (memcmp(ref, src, n * sizeof(*src))) {
+		fputs("  IN-PLACE MIXED CONVERSION DIFFERS\n", stderr);
+		rc = 1;
+	}
+out:
+	free(src);
+	free(ref);
+	free(res);
+	return rc;
+}
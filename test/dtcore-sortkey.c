@@ -0,0 +1,94 @@
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "dt-core.h"
+
+#define CHECK_RES(rc, pred, args...)		\
+	if (pred) {				\
+		fprintf(stderr, args);		\
+		res = rc;			\
+	}
+
+#define CHECK(pred, args...)			\
+	CHECK_RES(1, pred, args)
+
+static const struct {
+	const char *str;
+	const char *fmt;
+} tv[] = {
+	/* in ascending order, equal neighbours share a key */
+	{"1917-01-01", "%F"},
+	{"1969-12-31T23:59:59.999999900", "%FT%T.%N"},
+	{"1970-01-01", "%F"},
+	{"1970-01-01T00:00:00", "%FT%T"},
+	{"1", "%s"},
+	{"1970-01-01T00:00:01", "%FT%T"},
+	{"2012-06-30T23:59:59", "%FT%T"},
+	{"1341100799", "%s"},
+	{"1341100799.0000001", "%s.%N"},
+	{"2012-06-30T23:59:59.5", "%FT%T.%N"},
+	{"1341100799.5", "%s.%N"},
+	{"2012-07-01", "%F"},
+	{"2012-07-01T00:00:00", "%FT%T"},
+	{"2012-Jul-01-Sun", "%Y-%b-%c-%a"},
+	{"2012-W26-7", "%rY-W%V-%u"},
+	{"2012-183", "%Y-%j"},
+	{"2012-07-02", "%F"},
+	{"2099-12-31T23:59:59", "%FT%T"},
+};
+
+static int
+sortkey_chk(size_t i, struct dt_dt_s d1, struct dt_dt_s d2)
+{
+	const uint64_t k1 = dt_sortkey(d1);
+	const uint64_t k2 = dt_sortkey(d2);
+	/* neighbours with the same output in %FT%T.%N are equal */
+	char b1[64U], b2[64U];
+	int res = 0;
+
+	dt_strfdt(b1, sizeof(b1), "%FT%T.%N", d1);
+	dt_strfdt(b2, sizeof(b2), "%FT%T.%N", d2);
+
+	CHECK(!k1 || !k2, "  %zu: KEY IS NULL\n", i);
+	CHECK(k1 > k2, "  %zu: KEYS NOT ORDERED %s v %s\n", i, b1, b2);
+	if (dt_sandwich_only_d_p(d1) == dt_sandwich_only_d_p(d2)) {
+		const int eqp = !strcmp(b1, b2);
+
+		CHECK(eqp != (k1 == k2),
+		      "  %zu: KEY EQUALITY DIFFERS %s v %s\n", i, b1, b2);
+		CHECK(eqp != (dt_sortkey_hash(k1) == dt_sortkey_hash(k2)),
+		      "  %zu: HASH EQUALITY DIFFERS %s v %s\n", i, b1, b2);
+	}
+	if (dt_sandwich_only_d_p(d1)) {
+		CHECK(k1 != dt_dsortkey(d1.d),
+		      "  %zu: DATE KEYS DIFFER\n", i);
+	}
+	return res;
+}
+
+int
+main(void)
+{
+	int rc = 0;
+	struct dt_dt_s prev = dt_strpdt(tv[0U].str, tv[0U].fmt, NULL);
+
+	for (size_t i = 1U; i < sizeof(tv) / sizeof(*tv); i++) {
+		struct dt_dt_s this = dt_strpdt(tv[i].str, tv[i].fmt, NULL);
+
+		if (sortkey_chk(i, prev, this)) {
+			rc = 1;
+		}
+		prev = this;
+	}
+
+	/* unknowns sort first */
+	if (dt_sortkey((struct dt_dt_s){DT_UNK})) {
+		fputs("  UNKNOWN KEY NOT NULL\n", stderr);
+		rc = 1;
+	}
+	return rc;
+}